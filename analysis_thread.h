@@ -0,0 +1,32 @@
+#pragma once
+
+#include <thread.h>
+#include "audio_analyzer.h"
+
+/*
+ * Realtime analysis loop, decoupled from the UI draw loop
+ * The UI gets the results through AudioAnalyzer::fetch_new_results() and get_results()
+ */
+class AnalysisThread : public Thread
+{
+    AudioAnalyzer& m_analyzer;
+public:
+    AnalysisThread(AudioAnalyzer& analyzer) : Thread("AnalysisThread", true, false), m_analyzer(analyzer)
+    {
+    }
+
+    ~AnalysisThread()
+    {
+        stop();
+        join();
+    }
+
+    void entry() override
+    {
+        if (!m_analyzer.process())
+        {
+            // Not enough data in the recorder yet, poll again shortly
+            usleep(1000);
+        }
+    }
+};
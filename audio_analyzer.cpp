@@ -0,0 +1,1000 @@
+#define _USE_MATH_DEFINES
+#include "audio_analyzer.h"
+#include <array>
+#include <dsp_kernels.h>
+#include <algorithm>
+#include <cstring>
+
+void log_message(const char* format, ...);
+
+// W&F output low-pass presets (Hz), indexed by AnalysisSettings::wf_filter_freq_combo
+static const std::array<int, 4> WOW_FLUTTER_FILTER_FREQS = {0, 6, 20, 100};
+
+/*
+ * Run a capture kernel on both ring regions, kernel(in, frames, channels, offset) writes from
+ * the output frame offset. A frame split across the wrap point is reassembled in a small stack buffer
+ */
+template<class T, class F>
+static void for_each_region(const SpscRingBuffer::Regions& regions, int channels, F kernel)
+{
+    const T* data1 = (const T*)regions.data1;
+    const T* data2 = (const T*)regions.data2;
+    int frames1 = regions.size1 / channels;
+    int frames2 = regions.size2 / channels;
+    int split = regions.size1 % channels;
+
+    kernel(data1, frames1, channels, 0);
+
+    int offset = frames1;
+    if (split)
+    {
+        T frame[2] = {0};
+        const int needed = std::min(channels, 2);
+        for (int c = 0; c < needed; ++c)
+        {
+            frame[c] = c < split ? data1[frames1 * channels + c] : data2[c - split];
+        }
+        kernel(frame, 1, needed, offset);
+        offset += 1;
+        data2 += channels - split;
+        frames2 = (regions.size2 - (channels - split)) / channels;
+    }
+
+    if (frames2 > 0)
+    {
+        kernel(data2, frames2, channels, offset);
+    }
+}
+
+// Deinterleave, gain, window and RMS
+template<class T, class W>
+static void deinterleave_regions(const SpscRingBuffer::Regions& regions, int channels, double gain, const W* window,
+                                 double* out_l, double* out_r, W* win_l, W* win_r, double sumsq[2])
+{
+    for_each_region<T>(regions, channels, [&](const T* in, int frames, int in_channels, int offset){
+        deinterleave_capture(in, frames, in_channels, gain, window + offset, out_l + offset, out_r + offset,
+                             win_l + offset, win_r + offset, sumsq);
+    });
+}
+
+// Deinterleave and gain only
+template<class T>
+static void deinterleave_regions(const SpscRingBuffer::Regions& regions, int channels, double gain, double* out_l, double* out_r)
+{
+    for_each_region<T>(regions, channels, [&](const T* in, int frames, int in_channels, int offset){
+        deinterleave_gain(in, frames, in_channels, gain, out_l + offset, out_r + offset);
+    });
+}
+
+/*
+ * Deconvolution of a complete sweep capture, a few FFTs of up to 2^23 points kept out of the
+ * analysis thread. The task owns the capture, the response goes back through the sweep mutex
+ */
+class SweepAnalysisTask : public Thread
+{
+    AudioAnalyzer&      m_analyzer;
+    std::vector<double> m_capture;
+    int     m_sweep_id;
+    int     m_samplerate;
+    double  m_start_freq, m_end_freq, m_duration;
+
+public:
+    // Takes the content of capture
+    SweepAnalysisTask(AudioAnalyzer& analyzer, std::vector<double>& capture, int sweep_id, int samplerate,
+                      double start_freq, double end_freq, double duration)
+        : Thread("SweepAnalysisTask", false, false), m_analyzer(analyzer), m_sweep_id(sweep_id), m_samplerate(samplerate),
+          m_start_freq(start_freq), m_end_freq(end_freq), m_duration(duration)
+    {
+        m_capture.swap(capture);
+    }
+
+    void entry() override
+    {
+        Chrono chrono;
+        SweepResponse response;
+        bool valid = SweepAnalyzer::analyze(m_capture.data(), m_capture.size(), m_start_freq, m_end_freq, m_duration,
+                                            m_samplerate, response, &AudioAnalyzer::fftw_planner_mutex());
+        log_message("Sweep analysis : %s, latency %.1fms, %luus\n", valid ? "done" : "no response found",
+                    response.latency * 1000., chrono.get_elapsed_time());
+        m_analyzer.publish_sweep_response(m_sweep_id, response);
+    }
+};
+
+AudioAnalyzer::AudioAnalyzer(AudioSource& source, PAaudioLoopback* loopback) : m_audiosource(source), m_audioloopback(loopback)
+{
+    compute_fft_window_corrections();
+}
+
+AudioAnalyzer::~AudioAnalyzer()
+{
+    if (m_sweep_task)
+    {
+        m_sweep_task->join();
+        delete m_sweep_task;
+    }
+    destroy_capture();
+}
+
+ThreadMutex& AudioAnalyzer::fftw_planner_mutex()
+{
+    static ThreadMutex mutex;
+    return mutex;
+}
+
+void AudioAnalyzer::set_settings(const AnalysisSettings& settings)
+{
+    ScopedMutex lock(m_settings_mutex);
+    m_pending_settings = settings;
+}
+
+void AudioAnalyzer::compute_fft_window_cache()
+{
+    if (m_current_window_cache != nullptr) delete[] m_current_window_cache;
+    if (m_current_window_cache_f != nullptr) delete[] m_current_window_cache_f;
+    m_current_window_cache = new double[m_capture_size];
+    m_current_window_cache_f = new float[m_capture_size];
+
+    for(int i = 0; i < m_capture_size; ++i)
+    {
+        m_current_window_cache[i] = m_window_fn(i, m_capture_size);
+        m_current_window_cache_f[i] = m_current_window_cache[i];
+    }
+}
+
+static double (*get_window_fn(int index))(int, int)
+{
+    switch (index)
+    {
+        case 0:
+            return rectangle_fft_window;
+        case 1:
+            return hamming_fft_window;
+        case 2:
+            return hann_poisson_fft_window;
+        case 3:
+            return blackman_fft_window;
+        case 4:
+            return blackman_harris_fft_window;
+        case 5:
+            return hann_fft_window;
+        case 6:
+            return kaiser6_fft_window;
+        default:
+            return rectangle_fft_window;
+    }
+}
+
+void AudioAnalyzer::set_window_fn(int index)
+{
+    ScopedMutex lock(m_compute_mutex);
+
+    m_fft_window_fn_index = index;
+    m_window_fn = get_window_fn(index);
+
+    compute_fft_window_cache();
+    m_average_l.reset();
+    m_average_r.reset();
+}
+
+void AudioAnalyzer::compute_fft_window_corrections(int num_samples)
+{
+    const double inv_num_samples = 1. / num_samples;
+    for (int j = 0; j < 8; ++j)
+    {
+        double (*window_fn)(int, int) = get_window_fn(j);
+        double sum = 0;
+        double rms = 0;
+        for (int i = 0; i < num_samples; i++)
+        {
+            double val = window_fn(i, num_samples);
+            sum += val;
+            rms += val*val;
+        }
+
+        // Normalization
+        m_window_amplitude_correction[j] = 1.0 / (sum * inv_num_samples);
+        m_window_energy_correction[j] = 1.0 / sqrt(rms * inv_num_samples);
+        m_peak_interpolators[j].init(window_fn);
+    }
+}
+
+void AudioAnalyzer::detect_periods(AnalysisResults& results)
+{
+    const double timestep = 1. / (double)results.samplerate;
+    double const* audio_data = results.sound_data1.data();
+    std::vector<double> frequencies;
+
+    int previous_idx = 0;
+    double lastzerocross = 0;
+    double previous = audio_data[0];
+    double previous_time = 0;
+    double freq_mean = 0;
+    results.trigger_index = -1;
+
+    for (int i = 1; i < m_capture_size; ++i)
+    {
+        double current = audio_data[i];
+
+        if (previous < 0 && current > 0)
+        {
+            double a[2] = {timestep * ((double)i-1.), previous};
+            double b[2] = {timestep * (double)i, current};
+            double zcrosstime = zerocross(a,b);
+            if (lastzerocross > 0)
+            {
+                double freq = 1.0 / (zcrosstime - lastzerocross);
+                frequencies.push_back(freq);
+                freq_mean += freq;
+            }
+            lastzerocross = zcrosstime;
+            if (results.trigger_index < 0){
+                results.trigger_index = i;
+            }
+        }
+        previous = current;
+    }
+
+    if (frequencies.size() < 2)
+    {
+        results.frequency_counter = 0;
+        return;
+    }
+
+    freq_mean /= (double)frequencies.size();
+    results.frequency_counter = freq_mean;
+}
+
+bool AudioAnalyzer::process()
+{
+    ScopedMutex lock(m_compute_mutex);
+
+    m_settings_mutex.lock();
+    m_settings = m_pending_settings;
+    m_settings_mutex.unlock();
+    m_settings.fft_overlap = std::min(std::max(m_settings.fft_overlap, 0), 3);
+
+    const int channelcount = m_audiosource.get_channel_count();
+    if (channelcount == 0 || m_capture_size == 0)
+    {
+        return false;
+    }
+
+    if (m_audiosource.get_available_samples() < get_hop_size() * channelcount)
+    {
+        return false;
+    }
+
+    Chrono chrono;
+    AnalysisResults& results = m_results.back();
+
+    if (!compute(results))
+    {
+        return false;
+    }
+
+    // Slots are recycled, the bin indexes of a skipped stage are cleared for the UI
+    if (m_settings.compute_channel_phase || m_settings.show_thd)
+        compute_thd(results);
+    else
+        results.fft_found_peaks = 0;
+    if (m_settings.show_thd)
+        compute_thdn(results);
+    else
+        results.fft_fund_idx_range_min = results.fft_fund_idx_range_max = 0;
+    if (m_settings.compute_channel_phase)
+        compute_channels_phase(results);
+
+    results.compute_time = chrono.get_elapsed_time();
+
+    m_results.publish();
+
+    return true;
+}
+
+bool AudioAnalyzer::compute(AnalysisResults& results)
+{
+    const int channelcount = m_audiosource.get_channel_count();
+
+    const int hop_size = get_hop_size();
+    const size_t num_samples = hop_size * channelcount;
+    SpscRingBuffer::Regions regions;
+    if (!m_audiosource.peek_data(num_samples, regions)){
+        // Quick return in no new audio data to compute
+        return false;
+    }
+
+    // The recording goes on when the analysis is stopped, no block leaves the ring unwritten
+    if (m_recording)
+    {
+        m_capture_writer.push(regions.data1, regions.size1, regions.data2, regions.size2);
+    }
+
+    if (!m_settings.compute_on){
+        // Just consume data, if any
+        m_audiosource.consume_data(num_samples);
+        m_history_frames = 0;
+        m_audio_dropped = true;
+        return false;
+    }
+
+    // The W&F demodulator state doesn't span a gap in the audio
+    if (m_audio_dropped)
+    {
+        m_wf_stream.reset();
+        m_audio_dropped = false;
+    }
+
+    // Fill audio for audio loopback, the recorder and the loopback share the same sample format
+    if (m_settings.audio_loopback_on && m_audioloopback)
+    {
+        m_audioloopback->add_raw_data(regions.data1, regions.size1, regions.data2, regions.size2);
+    }
+
+    const int fft_capture_size = m_capture_size / 2;
+    const double current_sample_rate = m_audiosource.get_current_samplerate();
+    const double inv_current_sample_rate = 1.0 / current_sample_rate;
+    const double inv_fft_capture_size = 1.0 / float(fft_capture_size);
+    const double audio_gain = m_settings.audio_gain;
+
+    if (results.sound_data_x.size() != m_capture_size || results.samplerate != (int)current_sample_rate)
+    {
+        results.sound_data_x.resize(m_capture_size);
+        for (int i = 0; i < m_capture_size; i++)
+        {
+            results.sound_data_x[i] = float(i) * inv_current_sample_rate * 1000.0/* ->ms */;
+        }
+        results.fftfreqs = m_fftfreqs;
+    }
+
+    results.capture_size = m_capture_size;
+    results.samplerate = current_sample_rate;
+    results.channelcount = channelcount;
+
+    if (results.sound_data1.size() != m_capture_size) results.sound_data1.resize(m_capture_size);
+    if (results.sound_data2.size() != m_capture_size) results.sound_data2.resize(m_capture_size);
+    if (results.fftdrawl.size() != fft_capture_size) results.fftdrawl.resize(fft_capture_size);
+    if (results.fftdrawr.size() != fft_capture_size) results.fftdrawr.resize(fft_capture_size);
+
+    double* fftdrawl = results.fftdrawl.data();
+    double* fftdrawr = results.fftdrawr.data();
+
+    double sumsq[2] = {0, 0};
+    if (hop_size == m_capture_size)
+    {
+        // Deinterleave, gain, window and RMS in one pass straight from the ring buffer
+        if (m_single_precision)
+        {
+            if (m_audiosource.is_floatingpoint())
+                deinterleave_regions<float>(regions, channelcount, audio_gain, m_current_window_cache_f,
+                                            results.sound_data1.data(), results.sound_data2.data(), m_fftinl_f, m_fftinr_f, sumsq);
+            else
+                deinterleave_regions<int16_t>(regions, channelcount, audio_gain, m_current_window_cache_f,
+                                              results.sound_data1.data(), results.sound_data2.data(), m_fftinl_f, m_fftinr_f, sumsq);
+        }
+        else
+        {
+            if (m_audiosource.is_floatingpoint())
+                deinterleave_regions<float>(regions, channelcount, audio_gain, m_current_window_cache,
+                                            results.sound_data1.data(), results.sound_data2.data(), m_fftinl, m_fftinr, sumsq);
+            else
+                deinterleave_regions<int16_t>(regions, channelcount, audio_gain, m_current_window_cache,
+                                              results.sound_data1.data(), results.sound_data2.data(), m_fftinl, m_fftinr, sumsq);
+        }
+        m_audiosource.consume_data(num_samples);
+        m_history_frames = 0;
+
+        if (m_settings.show_wow_flutter)
+        {
+            compute_wow_and_flutter(m_settings.fft_channel_left ? results.sound_data1.data() : results.sound_data2.data(), hop_size);
+        }
+        if (m_sweep_capturing)
+        {
+            capture_sweep(m_settings.fft_channel_left ? results.sound_data1.data() : results.sound_data2.data(), hop_size);
+        }
+    }
+    else
+    {
+        // Overlapping analysis : slide the history by one hop and append the new frames
+        if (m_history_overlap != m_settings.fft_overlap)
+        {
+            m_history_overlap = m_settings.fft_overlap;
+            m_history_frames = 0;
+        }
+
+        const int keep = m_capture_size - hop_size;
+        memmove(m_history_l, m_history_l + hop_size, keep * sizeof(double));
+        memmove(m_history_r, m_history_r + hop_size, keep * sizeof(double));
+
+        // The new hop is windowed with the rest of the history once the window is full
+        if (m_audiosource.is_floatingpoint())
+            deinterleave_regions<float>(regions, channelcount, audio_gain, m_history_l + keep, m_history_r + keep);
+        else
+            deinterleave_regions<int16_t>(regions, channelcount, audio_gain, m_history_l + keep, m_history_r + keep);
+        m_audiosource.consume_data(num_samples);
+
+        // W&F and the sweep get every hop, the window doesn't need to be full
+        // Only the new frames are demodulated, the overlapping part is already in
+        if (m_settings.show_wow_flutter)
+        {
+            compute_wow_and_flutter((m_settings.fft_channel_left ? m_history_l : m_history_r) + keep, hop_size);
+        }
+        if (m_sweep_capturing)
+        {
+            capture_sweep((m_settings.fft_channel_left ? m_history_l : m_history_r) + keep, hop_size);
+        }
+
+        m_history_frames = std::min(m_history_frames + hop_size, m_capture_size);
+        if (m_history_frames < m_capture_size)
+        {
+            // Wait for a full window
+            return false;
+        }
+
+        if (m_single_precision) sumsq[0] = apply_window(m_history_l, m_current_window_cache_f, m_fftinl_f, m_capture_size);
+        else sumsq[0] = apply_window(m_history_l, m_current_window_cache, m_fftinl, m_capture_size);
+        memcpy(results.sound_data1.data(), m_history_l, m_capture_size * sizeof(double));
+        if (channelcount > 1)
+        {
+            if (m_single_precision) sumsq[1] = apply_window(m_history_r, m_current_window_cache_f, m_fftinr_f, m_capture_size);
+            else sumsq[1] = apply_window(m_history_r, m_current_window_cache, m_fftinr, m_capture_size);
+            memcpy(results.sound_data2.data(), m_history_r, m_capture_size * sizeof(double));
+        }
+    }
+    const double rms_left = sumsq[0], rms_right = sumsq[1];
+
+    detect_periods(results);
+
+    results.rms_left = sqrt(rms_left / m_capture_size);
+    results.rms_right = channelcount > 1 ? sqrt(rms_right / m_capture_size) : 0.;
+
+    double* current_fft_draw = m_settings.fft_channel_left ? fftdrawl : fftdrawr;
+
+    // Compute and fill audio FFT
+    if (m_single_precision)
+    {
+        if (channelcount > 1) ::fftwf_execute(m_fftplanlr_f);
+        else ::fftwf_execute(m_fftplanl_f);
+    }
+    else
+    {
+        if (channelcount > 1) ::fftw_execute(m_fftplanlr);
+        else ::fftw_execute(m_fftplanl);
+    }
+
+    // Accumulate the power spectra
+    m_average_l.set_mode(m_settings.fft_average_mode, m_settings.fft_average_count);
+    m_average_r.set_mode(m_settings.fft_average_mode, m_settings.fft_average_count);
+    if (m_reset_average.exchange(false))
+    {
+        m_average_l.reset();
+        m_average_r.reset();
+    }
+    if (m_single_precision)
+    {
+        m_average_l.add((const float*)m_fftoutl_f);
+        if (channelcount > 1) m_average_r.add((const float*)m_fftoutr_f);
+    }
+    else
+    {
+        m_average_l.add((const double*)m_fftoutl);
+        if (channelcount > 1) m_average_r.add((const double*)m_fftoutr);
+    }
+    results.average_count = m_average_l.count();
+
+    const double* power_l = m_average_l.power();
+    const double* power_r = m_average_r.power();
+    // 20log10(|X| * correction / N) computed from the power |X|^2
+    const double db_offset = linear_to_db(inv_fft_capture_size * m_window_amplitude_correction[m_fft_window_fn_index]);
+
+    double sum = power_to_db(power_l, fft_capture_size, db_offset, -200.0, fftdrawl);
+    if (channelcount > 1)
+    {
+        double sum_r = power_to_db(power_r, fft_capture_size, db_offset, -200.0, fftdrawr);
+        if (!m_settings.fft_channel_left) sum = sum_r;
+    }
+    else if (!m_settings.fft_channel_left)
+    {
+        sum = 0;
+    }
+
+    fftdrawr[0] *= 0.5;
+    fftdrawl[0] *= 0.5;
+
+    double mean = sum * inv_fft_capture_size;
+    double stddev = 0;
+    for (int i = 0; i < fft_capture_size; ++i)
+    {
+        double a = (current_fft_draw[i] - mean);
+        stddev += a * a;
+    }
+    stddev = sqrt(stddev / float(fft_capture_size - 1));
+    results.noise_floor = mean + stddev;
+
+    compute_multitone(results, db_offset);
+
+    return true;
+}
+
+void AudioAnalyzer::reset_wow_flutter()
+{
+    ScopedMutex lock(m_compute_mutex);
+
+    m_wf_stream.reset();
+    publish_wow_flutter(0);
+}
+
+void AudioAnalyzer::start_sweep_capture(double start_freq, double end_freq, double duration, double tail)
+{
+    ScopedMutex lock(m_compute_mutex);
+    ScopedMutex sweep_lock(m_sweep_mutex);
+
+    m_sweep_start_freq = start_freq;
+    m_sweep_end_freq = end_freq;
+    m_sweep_duration = duration;
+    m_sweep_capture.resize(int((duration + tail) * m_audiosource.get_current_samplerate()));
+    m_sweep_captured = 0;
+    m_sweep_capturing = !m_sweep_capture.empty();
+    m_sweep_analysing = false;
+    m_sweep_id++;
+    m_new_sweep_response = false;
+}
+
+bool AudioAnalyzer::fetch_sweep_response(SweepResponse& response)
+{
+    if (!m_new_sweep_response.exchange(false)) return false;
+    ScopedMutex lock(m_sweep_mutex);
+    response = m_sweep_response;
+    return true;
+}
+
+void AudioAnalyzer::capture_sweep(const double* audio_data, int size)
+{
+    const int count = std::min(size, (int)m_sweep_capture.size() - m_sweep_captured);
+    std::copy(audio_data, audio_data + count, m_sweep_capture.begin() + m_sweep_captured);
+    m_sweep_captured += count;
+    if (m_sweep_captured < (int)m_sweep_capture.size()) return;
+
+    // Complete, the deconvolution runs on its own thread, the previous one is long finished
+    if (m_sweep_task)
+    {
+        m_sweep_task->join();
+        delete m_sweep_task;
+    }
+    {
+        ScopedMutex lock(m_sweep_mutex);
+        m_sweep_capturing = false;
+        m_sweep_analysing = true;
+    }
+    m_sweep_task = new SweepAnalysisTask(*this, m_sweep_capture, m_sweep_id, m_audiosource.get_current_samplerate(),
+                                         m_sweep_start_freq, m_sweep_end_freq, m_sweep_duration);
+    m_sweep_task->start();
+}
+
+void AudioAnalyzer::publish_sweep_response(int sweep_id, const SweepResponse& response)
+{
+    ScopedMutex lock(m_sweep_mutex);
+
+    // A capture restarted meanwhile waits for its own response
+    if (sweep_id != m_sweep_id) return;
+    m_sweep_analysing = false;
+    m_sweep_response = response;
+    m_new_sweep_response = true;
+}
+
+void AudioAnalyzer::compute_wow_and_flutter(const double* audio_data, int size)
+{
+    Chrono chrono;
+
+    const int filter_combo = m_settings.wf_filter_freq_combo;
+    m_wf_stream.configure(m_settings.wow_reference_frequency,
+                          filter_combo < (int)WOW_FLUTTER_FILTER_FREQS.size() ? WOW_FLUTTER_FILTER_FREQS[filter_combo] : 0);
+
+    // Only the new samples are demodulated, nothing is dropped
+    m_wf_stream.process(audio_data, size);
+    publish_wow_flutter(chrono.get_elapsed_time());
+}
+
+void AudioAnalyzer::publish_wow_flutter(unsigned long compute_time)
+{
+    // Written while the UI reads the front frame, the plot data is only exchanged once complete
+    WowFlutterFrame& frame = m_wow_frames.back();
+    frame.compute_time = compute_time;
+    frame.buffering = m_wf_stream.buffering();
+    if (frame.buffering)
+    {
+        // Recycled slot, nothing from a previous measure is shown
+        std::fill(frame.deviation.begin(), frame.deviation.end(), 0.);
+        std::fill(frame.signal_i.begin(), frame.signal_i.end(), 0.);
+        std::fill(frame.signal_q.begin(), frame.signal_q.end(), 0.);
+        std::fill(frame.fft.begin(), frame.fft.end(), 0.);
+        frame.peak = frame.mean = 0;
+        m_wow_frames.publish();
+        return;
+    }
+
+    m_wf_stream.get_history(frame.deviation.data(), frame.signal_i.data(), frame.signal_q.data());
+
+    // I start the measure a little after the beginning, same window as the plot
+    const int decimated_size = frame.deviation.size();
+    double max_dev = -1000, min_dev = 1000, mean = 0;
+    int num_samples = 0;
+    for (int i = decimated_size/10; i < decimated_size; ++i)
+    {
+        double current = frame.deviation[i];
+        if (current > max_dev) max_dev = current;
+        if (current < min_dev) min_dev = current;
+        mean += current;
+        num_samples++;
+    }
+
+    mean /= num_samples;
+    double peak_plus = fabs(max_dev - mean);
+    double peak_minus = fabs(mean - min_dev);
+    frame.peak = peak_plus > peak_minus ? peak_plus : peak_minus;
+    frame.mean = mean;
+
+    // Process FFT compute of the W&F data, the plan input is the end of the deviation
+    if (m_settings.show_wf_fft_view)
+    {
+        std::copy(frame.deviation.end() - m_wow_fft_size, frame.deviation.end(), m_wow_fft_in);
+        fftw_execute(m_fftplanwow);
+
+        const int fftdraw_size = frame.fft.size();
+        const double inv_fft_capture_size = 1./fftdraw_size;
+        for(int i = 0; i < fftdraw_size; ++i)
+        {
+            frame.fft[i] = complex_module(m_wow_complex_out[i][FFTW_IMAGINARY_INDEX], m_wow_complex_out[i][FFTW_REAL_INDEX]) * inv_fft_capture_size;
+        }
+
+        // Normalize DC component
+        frame.fft[0] *= 0.5;
+    }
+    m_wow_frames.publish();
+}
+
+void AudioAnalyzer::compute_channels_phase(AnalysisResults& results)
+{
+    if (results.channelcount < 2) return;
+
+    float fft_capture_size = m_capture_size / 2;
+
+    // Get the fundamental frequency FFT result
+    double right_comp[2], left_comp[2];
+    get_fft_bin(true, results.fft_harmonics_idx[0], right_comp[0], right_comp[1]);
+    get_fft_bin(false, results.fft_harmonics_idx[0], left_comp[0], left_comp[1]);
+
+    // Compute the phase (complex argument) of left and right channels
+    double right_phase = wrap_phase(atan2(right_comp[1], right_comp[0]));
+    double left_phase = wrap_phase(atan2(left_comp[1], left_comp[0]));
+    // Compute the phase difference and convert to degrees
+    results.phase_diff_degrees = wrap_phase(right_phase - left_phase) * 180. / M_PI;
+
+    // Compute amplitude difference (diff of complex modules)
+    double left_amplitude  = complex_module(left_comp[0], left_comp[1]) / fft_capture_size;
+    double right_amplitude = complex_module(right_comp[0], right_comp[1]) / fft_capture_size;
+
+    // Convert to dB
+    results.left_right_db = 20. * log10(left_amplitude / right_amplitude);
+
+    if (m_phase_time.size() < PHASE_HISTORY_SIZE)
+    {
+        m_phase_history.push_back(results.phase_diff_degrees);
+        m_lrdiff_history.push_back(results.left_right_db);
+        m_phase_time.push_back(m_phase_time.size());
+    }
+    else
+    {
+        memmove(m_phase_history.data(), &m_phase_history[1], (m_phase_history.size() - 1) * sizeof(float));
+        memmove(m_lrdiff_history.data(), &m_lrdiff_history[1], (m_lrdiff_history.size() - 1) * sizeof(float));
+        m_phase_history.back() = results.phase_diff_degrees;
+        m_lrdiff_history.back() = results.left_right_db;
+    }
+
+    // The history keeps going on between the two frames
+    results.phase_history = m_phase_history;
+    results.lrdiff_history = m_lrdiff_history;
+    results.phase_time = m_phase_time;
+}
+
+void AudioAnalyzer::get_fft_bin(bool left, int index, double& re, double& im)
+{
+    if (m_single_precision)
+    {
+        const fftwf_complex& bin = left ? m_fftoutl_f[index] : m_fftoutr_f[index];
+        re = bin[0];
+        im = bin[1];
+    }
+    else
+    {
+        const fftw_complex& bin = left ? m_fftoutl[index] : m_fftoutr[index];
+        re = bin[0];
+        im = bin[1];
+    }
+}
+
+const double* AudioAnalyzer::current_power(const AnalysisResults& results)
+{
+    return (results.channelcount > 1 && !m_settings.fft_channel_left) ? m_average_r.power() : m_average_l.power();
+}
+
+const double* AudioAnalyzer::block_power(const AnalysisResults& results)
+{
+    return (results.channelcount > 1 && !m_settings.fft_channel_left) ? m_average_r.last_power() : m_average_l.last_power();
+}
+
+void AudioAnalyzer::compute_thd(AnalysisResults& results)
+{
+    const double* power = current_power(results);
+    const int fft_capture_size = m_capture_size / 2;
+    const double bin_hz = results.samplerate / double(m_capture_size);
+
+    m_harmonics.compute_thd(power, fft_capture_size, bin_hz, m_peak_interpolators[m_fft_window_fn_index]);
+
+    results.fft_found_peaks = m_harmonics.found_peaks;
+    for (int i = 0; i < m_harmonics.found_peaks; ++i)
+    {
+        results.fft_harmonics_idx[i] = m_harmonics.harmonics_idx[i];
+        results.fft_harmonics_freq[i] = m_harmonics.harmonics_freq[i];
+    }
+    results.thd = m_harmonics.thd;
+}
+
+void AudioAnalyzer::compute_multitone(AnalysisResults& results, double db_offset)
+{
+    const std::vector<double>& freqs = m_settings.multitone_freqs;
+    results.multitone_freqs.resize(freqs.size());
+    results.multitone_levels.resize(freqs.size());
+    if (freqs.empty()) return;
+
+    // The tones sit on bins when the generator and the recorder share the samplerate,
+    // the interpolation covers a mismatch. The levels come from this block only, an average
+    // would hold blocks from before the stimulus reached the input
+    const double* power = block_power(results);
+    const int fft_capture_size = m_capture_size / 2;
+    const double freq_to_bin = m_capture_size / double(results.samplerate);
+    const PeakInterpolator& interpolator = m_peak_interpolators[m_fft_window_fn_index];
+    for (size_t i = 0; i < freqs.size(); ++i)
+    {
+        double bin = 0, peak_power = 0;
+        interpolator.locate(power, fft_capture_size, freqs[i] * freq_to_bin, 1, bin, peak_power);
+        results.multitone_freqs[i] = freqs[i];
+        results.multitone_levels[i] = peak_power > 0 ? 10. * log10(peak_power) + db_offset : -200.;
+    }
+}
+
+void AudioAnalyzer::compute_thdn(AnalysisResults& results)
+{
+    const double energy_correction = m_window_energy_correction[m_fft_window_fn_index] * m_window_energy_correction[m_fft_window_fn_index];
+
+    // Uses the fundamental located by compute_thd()
+    m_harmonics.compute_thdn(current_power(results), m_capture_size / 2, energy_correction, m_spectrum_integrator);
+
+    results.fft_rms = m_harmonics.fft_rms;
+    results.fft_fund_idx_range_min = m_harmonics.fund_idx_range_min;
+    results.fft_fund_idx_range_max = m_harmonics.fund_idx_range_max;
+    results.thdn = m_harmonics.thdn;
+    results.thddb = m_harmonics.thdn_db;
+    results.thdn_audio_band = m_harmonics.thdn_audio_band;
+    results.thdn_a_weighted = m_harmonics.thdn_a_weighted;
+}
+
+void AudioAnalyzer::set_wisdom_path(const std::string& path)
+{
+    ScopedMutex lock(m_compute_mutex);
+
+    m_wisdom_path = path;
+    if (m_wisdom_path.empty()) return;
+
+    // A missing file is not an error, it is created by the first measured plan
+    fftw_import_wisdom_from_filename((m_wisdom_path + ".fftw_wisdom").c_str());
+    fftwf_import_wisdom_from_filename((m_wisdom_path + ".fftwf_wisdom").c_str());
+}
+
+void AudioAnalyzer::init_capture(int capture_size, int samplerate, bool optimized_fft, bool single_precision)
+{
+    ScopedMutex lock(m_compute_mutex);
+    ScopedMutex planner_lock(fftw_planner_mutex());
+
+    if (capture_size == 0) return;
+
+    // The recorder format may have changed. The writer is flushed with the lock held here,
+    // callers stop the recording first (see AudioToolWindow::reinit_recorder())
+    if (m_recording)
+    {
+        stop_recording();
+        log_message("Recording stopped, the input has been reconfigured");
+    }
+
+    destroy_capture();
+
+    m_capture_size = capture_size;
+    m_single_precision = single_precision;
+    int fft_capture_size = capture_size / 2;
+
+    const double fft_step = samplerate / 2.0 / fft_capture_size;
+    m_fftfreqs.resize(fft_capture_size);
+    for (int i = 0; i < fft_capture_size; ++i) m_fftfreqs[i] = fft_step * (double)(i);
+
+    m_wow_flutter_capture_size = samplerate / WOW_FLUTTER_DECIMATION * WOW_FLUTTER_ANALYSIS_TIME;
+    const int wow_capture_size = samplerate / WOW_FLUTTER_DECIMATION * (WOW_FLUTTER_ANALYSIS_TIME - 0.5f);
+    m_wow_fft_size = wow_capture_size;
+
+    if (m_single_precision)
+    {
+        m_fftinl_f  = new float[capture_size * 2];
+        m_fftoutl_f = new fftwf_complex[capture_size * 2];
+        m_fftinr_f  = m_fftinl_f + capture_size;
+        m_fftoutr_f = m_fftoutl_f + capture_size;
+    }
+    else
+    {
+        m_fftinl    = new double[capture_size * 2];
+        m_fftoutl   = new fftw_complex[capture_size * 2];
+        m_fftinr    = m_fftinl + capture_size;
+        m_fftoutr   = m_fftoutl + capture_size;
+    }
+    m_spectrum_integrator.init(fft_capture_size, double(samplerate) / capture_size);
+    m_average_l.init(fft_capture_size);
+    m_average_r.init(fft_capture_size);
+    m_history_l     = new double[capture_size];
+    m_history_r     = new double[capture_size];
+    m_history_frames = 0;
+    std::fill(m_history_l, m_history_l + capture_size, 0.);
+    std::fill(m_history_r, m_history_r + capture_size, 0.);
+    m_wow_fft_in            = new double[wow_capture_size];
+    m_wow_complex_out       = new fftw_complex[wow_capture_size];
+
+    // The analysis is stopped and the UI reads the frames from this thread, every slot is reset,
+    // no bin index of the previous capture size is left behind
+    m_results.for_each_slot([](AnalysisResults& slot){
+        slot = AnalysisResults();
+    });
+    const double wow_fft_step = (samplerate / WOW_FLUTTER_DECIMATION / 2.) / (wow_capture_size/2);
+    m_wow_frames.for_each_slot([&](WowFlutterFrame& frame){
+        frame.deviation.assign(m_wow_flutter_capture_size, 0.);
+        frame.signal_i.assign(m_wow_flutter_capture_size, 0.);
+        frame.signal_q.assign(m_wow_flutter_capture_size, 0.);
+        frame.fft.assign(wow_capture_size/2, 0.);
+        frame.time.resize(m_wow_flutter_capture_size);
+        frame.fft_freqs.resize(wow_capture_size/2);
+        frame.peak = frame.mean = 0;
+        frame.buffering = true;
+
+        // Start graph a little later to hide the filters settle time
+        for (int i = 0; i < m_wow_flutter_capture_size; ++i)
+        {
+            frame.time[i] = double((i - m_wow_flutter_capture_size / 10) * WOW_FLUTTER_DECIMATION) / samplerate;
+        }
+        for (int i = 0; i < wow_capture_size/2; ++i) frame.fft_freqs[i] = wow_fft_step * i;
+    });
+
+    m_wf_stream.init(samplerate, WOW_FLUTTER_DECIMATION, m_wow_flutter_capture_size);
+
+    unsigned int fft_flags = FFTW_PRESERVE_INPUT;
+
+    if (optimized_fft) fft_flags |= FFTW_MEASURE;
+    else fft_flags |= FFTW_ESTIMATE;
+
+    // Measured plans come from the wisdom when this FFT size is already known
+    bool wisdom_updated = false, wisdomf_updated = false;
+    auto make_plan = [&](auto planner, bool& updated) {
+        decltype(planner(0)) plan = NULL;
+        if (optimized_fft) plan = planner(fft_flags | FFTW_WISDOM_ONLY);
+        if (plan == NULL)
+        {
+            plan = planner(fft_flags);
+            updated |= optimized_fft;
+        }
+        return plan;
+    };
+
+    int fft_size[1] = {capture_size};
+    if (m_single_precision)
+    {
+        m_fftplanlr_f = make_plan([&](unsigned flags){
+            return fftwf_plan_many_dft_r2c(1, fft_size, 2, m_fftinl_f, NULL, 1, capture_size, m_fftoutl_f, NULL, 1, capture_size, flags);
+        }, wisdomf_updated);
+        m_fftplanl_f  = make_plan([&](unsigned flags){
+            return fftwf_plan_dft_r2c_1d(capture_size, m_fftinl_f, m_fftoutl_f, flags);
+        }, wisdomf_updated);
+    }
+    else
+    {
+        m_fftplanlr  = make_plan([&](unsigned flags){
+            return fftw_plan_many_dft_r2c(1, fft_size, 2, m_fftinl, NULL, 1, capture_size, m_fftoutl, NULL, 1, capture_size, flags);
+        }, wisdom_updated);
+        m_fftplanl   = make_plan([&](unsigned flags){
+            return fftw_plan_dft_r2c_1d(capture_size, m_fftinl, m_fftoutl, flags);
+        }, wisdom_updated);
+    }
+    m_fftplanwow = make_plan([&](unsigned flags){
+        return fftw_plan_dft_r2c_1d(wow_capture_size, m_wow_fft_in, m_wow_complex_out, flags);
+    }, wisdom_updated);
+
+    if (!m_wisdom_path.empty())
+    {
+        std::string wisdom_file = m_wisdom_path + ".fftw_wisdom";
+        if (wisdom_updated && !fftw_export_wisdom_to_filename(wisdom_file.c_str()))
+        {
+            log_message("Cannot save FFT wisdom to %s", wisdom_file.c_str());
+        }
+        std::string wisdomf_file = m_wisdom_path + ".fftwf_wisdom";
+        if (wisdomf_updated && !fftwf_export_wisdom_to_filename(wisdomf_file.c_str()))
+        {
+            log_message("Cannot save FFT wisdom to %s", wisdomf_file.c_str());
+        }
+    }
+
+    compute_fft_window_cache();
+}
+
+bool AudioAnalyzer::start_recording(const std::string& path)
+{
+    stop_recording();
+
+    ScopedMutex lock(m_compute_mutex);
+    const int channelcount = m_audiosource.get_channel_count();
+    if (channelcount == 0) return false;
+
+    m_recording = m_capture_writer.start_capture(path, m_audiosource.get_current_samplerate(), channelcount, m_audiosource.is_floatingpoint());
+    return m_recording;
+}
+
+void AudioAnalyzer::stop_recording()
+{
+    {
+        ScopedMutex lock(m_compute_mutex);
+        m_recording = false;
+    }
+    // The analysis doesn't push anymore, the queue is flushed without holding the lock
+    // unless the caller does, which stalls the analysis for up to CAPTURE_QUEUE_TIME
+    m_capture_writer.stop_capture();
+}
+
+void AudioAnalyzer::destroy_capture()
+{
+    ScopedMutex lock(m_compute_mutex);
+    ScopedMutex planner_lock(fftw_planner_mutex());
+
+    if (m_fftplanlr)  fftw_destroy_plan(m_fftplanlr);
+    if (m_fftplanl)   fftw_destroy_plan(m_fftplanl);
+    if (m_fftplanwow) fftw_destroy_plan(m_fftplanwow);
+    if (m_fftplanlr_f) fftwf_destroy_plan(m_fftplanlr_f);
+    if (m_fftplanl_f)  fftwf_destroy_plan(m_fftplanl_f);
+
+    delete[] m_fftinl;
+    delete[] m_fftoutl;
+    delete[] m_fftinl_f;
+    delete[] m_fftoutl_f;
+    delete[] m_wow_fft_in;
+    delete[] m_wow_complex_out;
+    m_spectrum_integrator.destroy();
+    delete[] m_current_window_cache;
+    delete[] m_current_window_cache_f;
+    delete[] m_history_l;
+    delete[] m_history_r;
+    m_average_l.destroy();
+    m_average_r.destroy();
+
+    m_fftinl    = nullptr;
+    m_fftoutl   = nullptr;
+    m_fftinr    = nullptr;
+    m_fftoutr   = nullptr;
+    m_fftplanlr = nullptr;
+    m_fftplanl  = nullptr;
+    m_fftinl_f  = nullptr;
+    m_fftoutl_f = nullptr;
+    m_fftinr_f  = nullptr;
+    m_fftoutr_f = nullptr;
+    m_fftplanlr_f = nullptr;
+    m_fftplanl_f  = nullptr;
+    m_fftplanwow = nullptr;
+    m_wow_fft_in = nullptr;
+    m_wow_complex_out = nullptr;
+    m_current_window_cache = nullptr;
+    m_current_window_cache_f = nullptr;
+    m_history_l = nullptr;
+    m_history_r = nullptr;
+    m_history_frames = 0;
+    m_capture_size = 0;
+}
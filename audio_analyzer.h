@@ -0,0 +1,292 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <fftw3.h>
+#include <thread.h>
+#include <utils.h>
+#include <spectrum_averager.h>
+#include <spectrum_integrator.h>
+#include <peak_interpolator.h>
+#include <harmonic_analysis.h>
+#include <triple_buffer.h>
+#include "audio_source.h"
+#include "audio_loopback.h"
+#include "wow_flutter_stream.h"
+#include "sweep_analyzer.h"
+#include "capture_writer.h"
+
+const double WOW_FLUTTER_ANALYSIS_TIME = 5.5;
+const int    WOW_FLUTTER_DECIMATION = 20;
+const int    PHASE_HISTORY_SIZE = 200;
+const int    MAX_HARMONICS = 20;
+
+class SweepAnalysisTask;
+
+/*
+ * User settings driving the analysis, pushed by the UI with AudioAnalyzer::set_settings()
+ * and latched at the beginning of each block
+ */
+struct AnalysisSettings
+{
+    bool    compute_on = false;
+    bool    audio_loopback_on = false;
+    bool    fft_channel_left = true;
+    bool    show_thd = false;
+    bool    compute_channel_phase = false;
+    bool    show_wow_flutter = false;
+    bool    show_wf_fft_view = false;
+    int     wow_reference_frequency = 3150;
+    int     wf_filter_freq_combo = 0;
+    int     fft_overlap = 0; // 0 : none, 1 : 50%, 2 : 75%, 3 : 87.5%
+    int     fft_average_mode = SpectrumAverager::NONE;
+    int     fft_average_count = 8;
+    double  audio_gain = 1.0;
+    // Tones of the multitone stimulus, their levels are read from every block when set
+    std::vector<double> multitone_freqs;
+};
+
+/*
+ * One analysis frame, the UI reads the front frame (see AudioAnalyzer::get_results())
+ * while the analysis thread fills the back one
+ */
+struct AnalysisResults
+{
+    int     capture_size = 0;
+    int     samplerate = 0;
+    int     channelcount = 0;
+
+    std::vector<double> sound_data1, sound_data2;
+    std::vector<double> sound_data_x;
+    std::vector<double> fftfreqs;
+    std::vector<double> fftdrawl, fftdrawr;
+
+    double  noise_floor = -100;
+    double  rms_left = 0, rms_right = 0;
+    double  frequency_counter = 0;
+    int     trigger_index = 0;
+
+    double  fft_harmonics_freq[MAX_HARMONICS] = {0};
+    int     fft_harmonics_idx[MAX_HARMONICS] = {0};
+    int     fft_found_peaks = 0;
+    int     fft_fund_idx_range_min = 0;
+    int     fft_fund_idx_range_max = 0;
+    double  thd = 0;
+    double  thdn = 0;
+    double  thddb = 0;
+    double  thdn_audio_band = 0;    // 20Hz - 20kHz
+    double  thdn_a_weighted = 0;
+    double  fft_rms = 0;
+    int     average_count = 0;
+
+    // Level of each multitone stimulus tone, dB full scale
+    std::vector<double> multitone_freqs;
+    std::vector<double> multitone_levels;
+
+    double  left_right_db = 0;
+    double  phase_diff_degrees = 0;
+    std::vector<float> phase_history;
+    std::vector<float> lrdiff_history;
+    std::vector<float> phase_time;
+
+    unsigned long compute_time = 0;
+};
+
+/*
+ * Wow & flutter view published with each demodulated block, same exchange as AnalysisResults
+ * The time and frequency axes are set in every slot by AudioAnalyzer::init_capture()
+ */
+struct WowFlutterFrame
+{
+    std::vector<double> deviation, time;    // Hz, seconds
+    // Decimated IQ, same time base as deviation
+    std::vector<double> signal_i, signal_q;
+    std::vector<double> fft_freqs, fft;
+    float   peak = 0;
+    float   mean = 0;
+    bool    buffering = true;
+    unsigned long compute_time = 0;
+};
+
+/*
+ * Realtime analysis engine : drains the audio source (recorder, file or synthetic signal), computes the time domain/FFT/THD pipeline
+ * and feeds the wow & flutter analysis.
+ * Nothing in here touches the UI, process() is called from AnalysisThread
+ */
+class AudioAnalyzer
+{
+    AudioSource&        m_audiosource;
+    PAaudioLoopback*    m_audioloopback;
+
+    AnalysisSettings    m_settings;
+    AnalysisSettings    m_pending_settings;
+    ThreadMutex         m_settings_mutex;
+
+    // Held while a block is processed, lock it to reconfigure the capture
+    ThreadMutex         m_compute_mutex;
+
+    // Front frames are read by the UI, back frames are written by process(), neither side waits
+    TripleBuffer<AnalysisResults>   m_results;
+    TripleBuffer<WowFlutterFrame>   m_wow_frames;
+
+    // Left and right FFT buffers are the two halves of the same allocation,
+    // stereo is transformed by a single plan_many plan
+    fftw_plan m_fftplanlr = NULL;
+    fftw_plan m_fftplanl = NULL;
+    fftw_plan m_fftplanwow = NULL;
+    double *m_fftinl = nullptr;
+    fftw_complex *m_fftoutl = nullptr;
+    double *m_fftinr = nullptr;
+    fftw_complex *m_fftoutr = nullptr;
+
+    // Single precision pipeline, used instead of the double FFT buffers and plans when enabled
+    bool m_single_precision = false;
+    fftwf_plan m_fftplanlr_f = NULL;
+    fftwf_plan m_fftplanl_f = NULL;
+    float *m_fftinl_f = nullptr;
+    fftwf_complex *m_fftoutl_f = nullptr;
+    float *m_fftinr_f = nullptr;
+    fftwf_complex *m_fftoutr_f = nullptr;
+
+    double *m_wow_fft_in = nullptr;
+    fftw_complex *m_wow_complex_out = nullptr;
+    int m_capture_size = 0;
+    // FFT frequency axis, only depends on the capture size and the samplerate
+    std::vector<double> m_fftfreqs;
+
+    // Sliding analysis, the last m_capture_size samples of each channel
+    double *m_history_l = nullptr;
+    double *m_history_r = nullptr;
+    int     m_history_frames = 0;
+    int     m_history_overlap = 0;
+    bool    m_audio_dropped = false;        // Blocks consumed without analysis since the last one
+
+    // Averaged power spectra, they feed the FFT plot and the THD/THD+N computations
+    SpectrumAverager    m_average_l;
+    SpectrumAverager    m_average_r;
+    std::atomic<bool>   m_reset_average{false};
+    // Cumulative power of the analysed channel for the THD+N band queries
+    SpectrumIntegrator  m_spectrum_integrator;
+    // Fundamental and harmonics of the last block, located by compute_thd() for compute_thdn()
+    HarmonicAnalysis    m_harmonics;
+
+    double  (*m_window_fn)(int, int) = hann_fft_window;
+    int     m_fft_window_fn_index = 5;
+    double  *m_current_window_cache = nullptr;
+    float   *m_current_window_cache_f = nullptr;
+    double  m_window_amplitude_correction[8] = {0.0};
+    double  m_window_energy_correction[8] = {0.0};
+    // Sub-bin peak location and scalloping loss for each window
+    PeakInterpolator m_peak_interpolators[8];
+
+    std::vector<float> m_phase_history;
+    std::vector<float> m_lrdiff_history;
+    std::vector<float> m_phase_time;
+
+    // Wow & flutter, demodulated block by block in the analysis thread
+    WowFlutterStream    m_wf_stream;
+    int     m_wow_flutter_capture_size = 0;
+    int     m_wow_fft_size = 0;             // Last points of the deviation transformed for the W&F FFT view
+
+    // Log sweep capture of the analysed channel, handed to a SweepAnalysisTask once complete
+    std::vector<double> m_sweep_capture;
+    int     m_sweep_captured = 0;
+    bool    m_sweep_capturing = false;
+    bool    m_sweep_analysing = false;
+    int     m_sweep_id = 0;                 // Changed by each start, the result of a previous sweep is dropped
+    double  m_sweep_start_freq = 20;
+    double  m_sweep_end_freq = 20000;
+    double  m_sweep_duration = 0;
+    SweepAnalysisTask*  m_sweep_task = nullptr;
+    SweepResponse       m_sweep_response;
+    std::atomic<bool>   m_new_sweep_response{false};
+    ThreadMutex         m_sweep_mutex;
+
+    // Raw recorder blocks teed to disk, the flag is only changed with m_compute_mutex held
+    CaptureWriter       m_capture_writer;
+    bool                m_recording = false;
+
+    std::string m_wisdom_path;
+
+    // Number of new frames needed for each analysis
+    int  get_hop_size(){return m_capture_size >> m_settings.fft_overlap;}
+    void compute_fft_window_cache();
+    void compute_fft_window_corrections(int num_samples = 1000);
+    // Power spectrum of the analysed channel, averaged or of the last block only
+    const double* current_power(const AnalysisResults& results);
+    const double* block_power(const AnalysisResults& results);
+    void get_fft_bin(bool left, int index, double& re, double& im);
+    void detect_periods(AnalysisResults& results);
+
+    bool compute(AnalysisResults& results);
+    void compute_wow_and_flutter(const double* audio_data, int size);
+    void publish_wow_flutter(unsigned long compute_time);
+    void compute_thdn(AnalysisResults& results);
+    void compute_thd(AnalysisResults& results);
+    void compute_channels_phase(AnalysisResults& results);
+    void compute_multitone(AnalysisResults& results, double db_offset);
+    void capture_sweep(const double* audio_data, int size);
+    void publish_sweep_response(int sweep_id, const SweepResponse& response);
+
+    friend class SweepAnalysisTask;
+
+public:
+    // The loopback is optional, it plays the source blocks as they are and needs its sample format
+    AudioAnalyzer(AudioSource& source, PAaudioLoopback* loopback = nullptr);
+    ~AudioAnalyzer();
+
+    ThreadMutex& compute_mutex(){return m_compute_mutex;}
+    // The FFTW planner isn't thread safe, every plan is made and destroyed with this lock held
+    static ThreadMutex& fftw_planner_mutex();
+
+    // FFTW wisdom kept across restarts (<path>.fftw_wisdom and <path>.fftwf_wisdom),
+    // imported now and updated when new plans are measured
+    void set_wisdom_path(const std::string& path);
+    void init_capture(int capture_size, int samplerate, bool optimized_fft, bool single_precision = false);
+    void destroy_capture();
+    int  capture_size() const {return m_capture_size;}
+
+    void set_settings(const AnalysisSettings& settings);
+    void set_window_fn(int index);
+    // Restart the spectrum averaging on the next block
+    void reset_average(){m_reset_average = true;}
+
+    /*
+     * Process one block of audio if available
+     * Returns false if the source doesn't hold enough data yet
+     */
+    bool process();
+
+    /*
+     * Picks up the newest result and wow & flutter frames, returns true once for every new result frame
+     * The front frames below stay unchanged until the next call, always call it from the same thread
+     */
+    bool fetch_new_results()
+    {
+        m_wow_frames.fetch();
+        return m_results.fetch();
+    }
+    const AnalysisResults& get_results() const {return m_results.front();}
+    const WowFlutterFrame& get_wow_flutter() const {return m_wow_frames.front();}
+    void  reset_wow_flutter();
+
+    /*
+     * Record the analysed channel for the sweep duration plus tail seconds, start it before the stimulus
+     * The tail must cover the output to input latency
+     */
+    void  start_sweep_capture(double start_freq, double end_freq, double duration, double tail);
+    // True until the response of the last started capture is available
+    bool  sweep_capture_running(){ScopedMutex lock(m_sweep_mutex); return m_sweep_capturing || m_sweep_analysing;}
+    // Copies the response and returns true once for every completed capture
+    bool  fetch_sweep_response(SweepResponse& response);
+
+    /*
+     * Record the input to a WAV file in the source format, while the analysis is running
+     * The recording is stopped when the capture is reinitialized
+     */
+    bool  start_recording(const std::string& path);
+    void  stop_recording();
+    bool  recording() const {return m_capture_writer.capturing();}
+    const CaptureWriter& capture_writer() const {return m_capture_writer;}
+};
@@ -85,7 +85,7 @@ void interpolate_linear_to_hspline_curve(const std::vector<double> &freqs, const
 }
 
 
-void AudioToolWindow::draw_sweep_tab()
+void AudioToolWindow::draw_sweep_tab(const AnalysisResults& results)
 {
     int channelcount = m_audiorecorder.get_channel_count(); 
     float current_sample_rate = m_audiorecorder.get_current_samplerate();
@@ -104,13 +104,22 @@ void AudioToolWindow::draw_sweep_tab()
             }
             ImGui::SameLine();
             ImGui::ToggleButton("Async", &m_async_sweep);
+            ImGui::SetItemTooltip("Switch between synchronous and asynchronous capture");
+            if (!m_async_sweep)
+            {
+                ImGui::SameLine();
+                if (ImGui::ToggleButton("Multitone", &m_multitone_sweep) && m_multitone_sweep) m_log_sweep = false;
+                ImGui::SetItemTooltip("Play all the tones at once and measure them from a single block");
+                ImGui::SameLine();
+                if (ImGui::ToggleButton("Log sweep", &m_log_sweep) && m_log_sweep) m_multitone_sweep = false;
+                ImGui::SetItemTooltip("Exponential sine sweep, gives the phase and the harmonic distortion");
+            }
         } else {
             if (ImGui::Button("Stop"))
             {
                 stop_sweep_gen();
             }
         }
-        ImGui::SetItemTooltip("Switch between synchronous and asynchronous capture");
     ImGui::EndChild();
 
     ImGui::SameLine();
@@ -135,8 +144,16 @@ void AudioToolWindow::draw_sweep_tab()
         ImGui::SameLine();
             ImGui::BeginChild("ScopesChildSpan", ImVec2(0.0f, 0.0f), ImGuiChildFlags_Border | ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_AutoResizeX, ImGuiWindowFlags_None);
             ImGui::SetNextItemWidth(70);
-            ImGui::DragInt("Sweep capture #", &m_sweep_capture_num, 10.f, 10, 500);
-            ImGui::SetItemTooltip("Number of measurement points");
+            if (m_log_sweep)
+            {
+                ImGui::DragFloat("Sweep duration (s)", &m_log_sweep_duration, 0.1f, 1.f, 20.f, "%.1f");
+                ImGui::SetItemTooltip("Longer sweeps give more signal to noise ratio");
+            }
+            else
+            {
+                ImGui::DragInt("Sweep capture #", &m_sweep_capture_num, 10.f, 10, 500);
+                ImGui::SetItemTooltip("Number of measurement points");
+            }
         ImGui::EndChild();
     } else {
         ImGui::SameLine();
@@ -152,7 +169,7 @@ void AudioToolWindow::draw_sweep_tab()
         ImGui::SetNextItemWidth(150);
         if (ImGui::Combo("Window mode", &m_fft_window_fn_index, vector_getter, (void *)&m_wmodes, m_wmodes.size()))
         {
-            set_window_fn();
+            m_analyzer.set_window_fn(m_fft_window_fn_index);
         }
         ImGui::SetItemTooltip("Set the FFT window mode");
     ImGui::EndChild();
@@ -234,11 +251,16 @@ void AudioToolWindow::draw_sweep_tab()
             ImPlot::SetupAxis(ImAxis_Y2, "dBu", 0);
             ImPlot::SetupAxisLimits(ImAxis_Y2, -120 + diffdb, diffdb, ImPlotCond_Always);
         }
+        if (!m_sweep_response.freqs.empty())
+        {
+            ImPlot::SetupAxis(ImAxis_Y3, "Phase (deg)", ImPlotAxisFlags_AuxDefault);
+            ImPlot::SetupAxisLimits(ImAxis_Y3, -180., 180.);
+        }
 
-        if (channelcount>0 && m_fftfreqs)
+        if (channelcount>0 && !results.fftfreqs.empty())
         {
-            ImPlot::PlotLine("Audio FFT", m_fftfreqs, m_fft_channel_left  ?  m_fftdrawl : m_fftdrawr, m_sound_data_x.size()/2);
-            double nf[4] = {0., (current_sample_rate)/2.0, m_noise_foor, m_noise_foor};
+            ImPlot::PlotLine("Audio FFT", results.fftfreqs.data(), m_fft_channel_left  ?  results.fftdrawl.data() : results.fftdrawr.data(), results.fftfreqs.size());
+            double nf[4] = {0., (current_sample_rate)/2.0, results.noise_floor, results.noise_floor};
             ImPlot::PlotLine("Noise floor", nf, nf+2, 2);
             if (m_sweep_freqs.size() > 3){
                 std::vector<double> xspline(400), yspline(400);
@@ -253,6 +275,24 @@ void AudioToolWindow::draw_sweep_tab()
             ImPlot::PlotLine(m_mem_sweeps_names[i++].c_str(), sweep_result.first.data(), sweep_result.second.data(), sweep_result.second.size());
         }
 
+        if (!m_sweep_response.harmonic_freqs.empty())
+        {
+            // Distortion relative to the fundamental, phase on its own axis
+            const SweepResponse& response = m_sweep_response;
+            std::vector<double> thd_db(response.thd_percent.size());
+            for (size_t j = 0; j < thd_db.size(); ++j) thd_db[j] = linear_to_db(std::max(response.thd_percent[j] * 0.01, 1e-10));
+            ImPlot::PlotLine("THD (dBc)", response.harmonic_freqs.data(), thd_db.data(), thd_db.size());
+            for (int k = 0; k < SWEEP_HARMONICS - 1; ++k)
+            {
+                char name[16];
+                snprintf(name, 16, "H%i (dBc)", k + 2);
+                ImPlot::PlotLine(name, response.harmonic_freqs.data(), response.harmonics_db[k].data(), response.harmonic_freqs.size());
+            }
+            ImPlot::SetAxes(ImAxis_X1, ImAxis_Y3);
+            ImPlot::PlotLine("Phase", response.freqs.data(), response.phase_deg.data(), response.freqs.size());
+            ImPlot::SetAxes(ImAxis_X1, ImAxis_Y1);
+        }
+
         float sweep_bar[4] = {(float)m_sweep_last_measure_freq, (float)m_sweep_last_measure_freq, 40.0, -200.0};
         ImPlot::PlotLine("Sweep", sweep_bar, sweep_bar+2, 2);
         
@@ -291,14 +331,14 @@ void AudioToolWindow::draw_lcd(const float value, const ImVec2 size, const int l
     draw_list->PopClipRect();
 }
 
-void AudioToolWindow::draw_audio_time_domain_widget(int plotheight, int current_sample_rate, int channelcount)
+void AudioToolWindow::draw_audio_time_domain_widget(const AnalysisResults& results, int plotheight, int current_sample_rate, int channelcount)
 {
     if (ImPlot::BeginPlot("Audio", ImVec2(m_show_wow_flutter ? width()-plotheight*2-10 : -1, -1)))
     {
         bool triggered = false;
-        const int trigger_space = m_capture_size / 10;
-        int computed_capture_size = m_capture_size;
-        if (m_trigger_on && m_trigger_index > 0 && m_trigger_index < trigger_space)
+        const int trigger_space = results.capture_size / 10;
+        int computed_capture_size = results.capture_size;
+        if (m_trigger_on && results.trigger_index > 0 && results.trigger_index < trigger_space)
         {
             computed_capture_size -= trigger_space;
             triggered = true;
@@ -324,11 +364,12 @@ void AudioToolWindow::draw_audio_time_domain_widget(int plotheight, int current_
             if (m_scopezoom < 1) m_scopezoom = 1;
             if (m_scopezoom > 50) m_scopezoom = 50;
         }
-        double* left_data = m_sound_data1.data() + (triggered ? m_trigger_index : 0);
-        double* right_data = m_sound_data2.data() + (triggered ? m_trigger_index : 0);
+        const double* left_data = results.sound_data1.data() + (triggered ? results.trigger_index : 0);
+        const double* right_data = results.sound_data2.data() + (triggered ? results.trigger_index : 0);
+        const int plot_size = results.sound_data_x.size() - (triggered ? results.trigger_index : 0);
         
-        if (channelcount > 0) ImPlot::PlotLine("Left channel", m_sound_data_x.data(), left_data, m_sound_data_x.size());
-        if (channelcount > 1) ImPlot::PlotLine("Right channel", m_sound_data_x.data(), right_data, m_sound_data_x.size());
+        if (channelcount > 0) ImPlot::PlotLine("Left channel", results.sound_data_x.data(), left_data, plot_size);
+        if (channelcount > 1) ImPlot::PlotLine("Right channel", results.sound_data_x.data(), right_data, plot_size);
         
         char rmstext[20];
         ImVec2 plotpos  = ImPlot::GetPlotPos();
@@ -336,18 +377,18 @@ void AudioToolWindow::draw_audio_time_domain_widget(int plotheight, int current_
 
         if (channelcount > 0)
         {
-            double rms[4] = {0., (current_sample_rate)/2.0, m_rms_left, m_rms_left};
+            double rms[4] = {0., (current_sample_rate)/2.0, results.rms_left, results.rms_left};
             ImPlot::PlotLine("signal RMS left", rms, rms+2, 2);
         }
         if (channelcount > 1)
         {
-            double rms[4] = {0., (current_sample_rate)/2.0, m_rms_right, m_rms_right};
+            double rms[4] = {0., (current_sample_rate)/2.0, results.rms_right, results.rms_right};
             ImPlot::PlotLine("signal RMS right", rms, rms+2, 2);
         }
 
         if(m_use_targetdb)
         {
-            if (!m_lockdb) m_locked_db_value = ((m_current_db_target_channel == 0) ? m_rms_left : m_rms_right) * pow(10, m_target_db/20.0);
+            if (!m_lockdb) m_locked_db_value = ((m_current_db_target_channel == 0) ? results.rms_left : results.rms_right) * pow(10, m_target_db/20.0);
             double tgtpnt[4] = {0., (current_sample_rate)/2.0, m_locked_db_value, m_locked_db_value};
             ImPlot::PlotLine("target dB", tgtpnt, tgtpnt+2, 2);
         }
@@ -377,6 +418,8 @@ void AudioToolWindow::draw_wow_flutter_widget(int channelcount, int current_samp
     float ref_frequency = 3150;
     static bool iq_view = false;
     static float iq_separation = 0.f;
+    // Front frame of the last fetch, stays valid while drawing
+    const WowFlutterFrame& wow_frame = m_analyzer.get_wow_flutter();
     
     ImGui::BeginChild("ChildWF", ImVec2(0, -1), ImGuiChildFlags_Border | ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_AutoResizeX | ImGuiWindowFlags_None);
 
@@ -437,7 +480,7 @@ void AudioToolWindow::draw_wow_flutter_widget(int channelcount, int current_samp
         ImGui::SameLine();
         ImGui::BeginChild("ScopesChildDebug", ImVec2(0.0f, 0.0f), ImGuiChildFlags_Border | ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_AutoResizeX, ImGuiWindowFlags_None);
         ImGui::AlignTextToFramePadding();
-        ImGui::Text("Thread time : %lums", m_wf_compute_time/1000);
+        ImGui::Text("Block time : %luus", wow_frame.compute_time);
         ImGui::EndChild();
     }
     static float max_freq = 100;
@@ -449,7 +492,7 @@ void AudioToolWindow::draw_wow_flutter_widget(int channelcount, int current_samp
     else if (m_wow_test_frequency == 2) ref_frequency = m_wow_test_frequency_custom;
 
     float max_percent = (max_freq / ref_frequency) * 100.;
-    bool is_buffering = m_longterm_audio.size() < WOW_FLUTTER_ANALYSIS_TIME * m_audiorecorder.get_current_samplerate();
+    bool is_buffering = wow_frame.buffering;
 
     if(!m_show_wf_fft_view && ImPlot::BeginPlot("Wow and flutter analysis (unweighted)", ImVec2(plotheight*2, -1)))
     {
@@ -479,37 +522,36 @@ void AudioToolWindow::draw_wow_flutter_widget(int channelcount, int current_samp
             if (max_freq > 500) max_freq = 500;
         }
         
-        m_wow_data_mutex.lock();
-            ImPlot::SetAxis(ImAxis_Y1);
-            ImPlot::PlotLine("Wow and flutter", m_wow_flutter_data_x.data(), m_wow_flutter_data.data(), m_wow_flutter_data.size());
-            
-            double wow_mean_bar[4] = {0., 5., m_wow_mean, m_wow_mean};
-            ImPlot::PlotLine("Wow & flutter mean", wow_mean_bar, wow_mean_bar+2, 2);
+        const std::vector<double>& wow_flutter_data = wow_frame.deviation;
+        const std::vector<double>& wow_flutter_data_x = wow_frame.time;
+        const float wow_mean = wow_frame.mean;
+        ImPlot::SetAxis(ImAxis_Y1);
+        ImPlot::PlotLine("Wow and flutter", wow_flutter_data_x.data(), wow_flutter_data.data(), wow_flutter_data.size());
+        
+        double wow_mean_bar[4] = {0., 5., wow_mean, wow_mean};
+        ImPlot::PlotLine("Wow & flutter mean", wow_mean_bar, wow_mean_bar+2, 2);
 
-            float peak_percent = (m_wow_peak_detection / (ref_frequency + m_wow_mean)) * 100.;
-            float freq_drift = (m_wow_mean / ref_frequency) * 100.;
-            if (!m_show_wf_fft_view && iq_view && m_signal_i.size() && m_signal_q.size())
-            {
-                std::pair<std::vector<double>, std::vector<double>> plotdatai(m_wow_flutter_data_x, m_signal_i);
-                std::pair<std::vector<double>, std::vector<double>> plotdataq(m_wow_flutter_data_x, m_signal_q);
-                
-                auto offsetter1 = [](int idx, void* data) -> ImPlotPoint { 
-                    int smp_idx = idx * WOW_FLUTTER_DECIMATION;
-                    auto& slice = *(std::pair<std::vector<double>, std::vector<double>>*)data;
-                    return ImPlotPoint(slice.first[idx], slice.second[smp_idx] + iq_separation);
-                };
-                auto offsetter2 = [](int idx, void* data) -> ImPlotPoint { 
-                    int smp_idx = idx * WOW_FLUTTER_DECIMATION;
-                    auto& slice = *(std::pair<std::vector<double>, std::vector<double>>*)data;
-                    return ImPlotPoint(slice.first[idx], slice.second[smp_idx] - iq_separation);
-                };
-
-                ImPlot::SetAxis(ImAxis_Y3);
-                ImPlot::PlotLineG("I", offsetter1, &plotdatai, m_wow_flutter_data_x.size());
-                ImPlot::PlotLineG("Q", offsetter2, &plotdataq, m_wow_flutter_data_x.size());
-                ImPlot::SetAxis(ImAxis_Y1);
-            }
-        m_wow_data_mutex.unlock();
+        float peak_percent = (wow_frame.peak / (ref_frequency + wow_mean)) * 100.;
+        float freq_drift = (wow_mean / ref_frequency) * 100.;
+        if (!m_show_wf_fft_view && iq_view && wow_frame.signal_i.size() && wow_frame.signal_q.size())
+        {
+            std::pair<std::vector<double>, std::vector<double>> plotdatai(wow_flutter_data_x, wow_frame.signal_i);
+            std::pair<std::vector<double>, std::vector<double>> plotdataq(wow_flutter_data_x, wow_frame.signal_q);
+            
+            auto offsetter1 = [](int idx, void* data) -> ImPlotPoint { 
+                auto& slice = *(std::pair<std::vector<double>, std::vector<double>>*)data;
+                return ImPlotPoint(slice.first[idx], slice.second[idx] + iq_separation);
+            };
+            auto offsetter2 = [](int idx, void* data) -> ImPlotPoint { 
+                auto& slice = *(std::pair<std::vector<double>, std::vector<double>>*)data;
+                return ImPlotPoint(slice.first[idx], slice.second[idx] - iq_separation);
+            };
+
+            ImPlot::SetAxis(ImAxis_Y3);
+            ImPlot::PlotLineG("I", offsetter1, &plotdatai, wow_flutter_data_x.size());
+            ImPlot::PlotLineG("Q", offsetter2, &plotdataq, wow_flutter_data_x.size());
+            ImPlot::SetAxis(ImAxis_Y1);
+        }
 
         char peak_text[64];
         snprintf(peak_text, 32, "W&F Peak: %.3f %%", peak_percent);
@@ -553,12 +595,11 @@ void AudioToolWindow::draw_wow_flutter_widget(int channelcount, int current_samp
             if (max_fft_freq > 500) max_fft_freq = 500;
         }
 
-        m_wow_data_mutex.lock();
-            ImPlot::PlotLine("Frequency drift", m_fftwowdrawfreqs.data(), m_fftdrawwow.data(), m_fftwowdrawfreqs.size());
-        m_wow_data_mutex.unlock();
+        const std::vector<double>& fftdrawwow = wow_frame.fft;
+        ImPlot::PlotLine("Frequency drift", wow_frame.fft_freqs.data(), fftdrawwow.data(), wow_frame.fft_freqs.size());
+        double wow_zero = fftdrawwow.size() ? fftdrawwow[0] : 0;
 
         char peak_text[64];
-        double wow_zero = m_fftdrawwow.size() ? m_fftdrawwow[0] : 0;
         float percent_drift = wow_zero / ref_frequency * 100.f;
         if (is_buffering)
         {
@@ -578,7 +619,7 @@ void AudioToolWindow::draw_wow_flutter_widget(int channelcount, int current_samp
     ImGui::EndChild();
 }
 
-void AudioToolWindow::draw_voltmeter_widget(int channelcount)
+void AudioToolWindow::draw_voltmeter_widget(const AnalysisResults& results, int channelcount)
 {
     if (m_rms_calibration_scale == 1.0)
         {
@@ -590,14 +631,14 @@ void AudioToolWindow::draw_voltmeter_widget(int channelcount)
             
         ImGui::BeginChild("ScopesChildVoltageLcd1", ImVec2(0, 0.0f), ImGuiChildFlags_Border | ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_AutoResizeX | ImGuiWindowFlags_None);
         TextCenter("Volts RMS Left");
-        draw_lcd(m_rms_left * m_rms_calibration_scale, ImVec2(180, 60), 6);
+        draw_lcd(results.rms_left * m_rms_calibration_scale, ImVec2(180, 60), 6);
         if (m_rms_calibration_scale != 1.){
-            double db = 20. * log10(m_rms_left * m_rms_calibration_scale / .775);
+            double db = 20. * log10(results.rms_left * m_rms_calibration_scale / .775);
             TextCenter("[%.2f dBu]", db);
         }
         if (m_lockdb && m_current_db_target_channel == 0)
         {
-            float target_val_left = 1.f - fabs( m_locked_db_value - m_rms_left * m_rms_calibration_scale ) * 10.f;
+            float target_val_left = 1.f - fabs( m_locked_db_value - results.rms_left * m_rms_calibration_scale ) * 10.f;
             ImGui::ProgressBar(target_val_left);
         }
         ImGui::EndChild();
@@ -606,14 +647,14 @@ void AudioToolWindow::draw_voltmeter_widget(int channelcount)
         {
             ImGui::BeginChild("ScopesChildVoltageLcd2", ImVec2(0, 0.0f), ImGuiChildFlags_Border | ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_AutoResizeX | ImGuiWindowFlags_None);
             TextCenter("Volts RMS Right");
-            draw_lcd(m_rms_right * m_rms_calibration_scale, ImVec2(180, 60), 6);
+            draw_lcd(results.rms_right * m_rms_calibration_scale, ImVec2(180, 60), 6);
             if (m_rms_calibration_scale != 1.){
-                double db = 20. * log10(m_rms_right * m_rms_calibration_scale / .775);
+                double db = 20. * log10(results.rms_right * m_rms_calibration_scale / .775);
                 TextCenter("[%.2f dBu]", db);
             }
             if (m_lockdb && m_current_db_target_channel == 1)
             {
-                float target_val_right = 1.f - fabs( m_locked_db_value - m_rms_right * m_rms_calibration_scale ) *10.f;
+                float target_val_right = 1.f - fabs( m_locked_db_value - results.rms_right * m_rms_calibration_scale ) *10.f;
                 ImGui::ProgressBar(target_val_right);
             }
             ImGui::EndChild();
@@ -622,20 +663,21 @@ void AudioToolWindow::draw_voltmeter_widget(int channelcount)
         ImGui::BeginChild("ScopesChildFreqCounter", ImVec2(0, 0.0f), ImGuiChildFlags_Border | ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_AutoResizeX | ImGuiWindowFlags_None);
         TextCenter("Frequency KHz");
         lcd_fg = IM_COL32(0,200,0,255);
-        draw_lcd(m_frequency_counter / 1000., ImVec2(180, 60), 6);
+        draw_lcd(results.frequency_counter / 1000., ImVec2(180, 60), 6);
         ImGui::EndChild();
 
         ImGui::EndChild();
         ImGui::SameLine();
 }
 
-void AudioToolWindow::draw_audio_fft_widget(int channelcount, int current_sample_rate, int plotheight)
+void AudioToolWindow::draw_audio_fft_widget(const AnalysisResults& results, int channelcount, int current_sample_rate, int plotheight)
 {
     if (ImPlot::BeginPlot("Audio FFT", ImVec2(m_compute_channel_phase ? width() - plotheight * 1.5f - 10 : -1, -1), ImPlotFlags_Crosshairs))
     {
 
         bool calibration_active = m_rms_calibration_scale != 1.0;
-        double* fft_draw = m_fft_channel_left  ? m_fftdrawl : m_fftdrawr;
+        const double* fftfreqs = results.fftfreqs.data();
+        const double* fft_draw = m_fft_channel_left  ? results.fftdrawl.data() : results.fftdrawr.data();
         float xfftmax = current_sample_rate > 0 ? (current_sample_rate)/2.f : INFINITY;
         ImPlot::SetupLegend(ImPlotLocation_NorthEast);
         ImPlot::SetupAxis(ImAxis_X1, "Frequency", 0);
@@ -656,31 +698,34 @@ void AudioToolWindow::draw_audio_fft_widget(int channelcount, int current_sample
             ImPlot::SetupAxisLimits(ImAxis_Y2, -120 + diffdb, diffdb, ImPlotCond_Always);
         }
 
-        if (m_fftfreqs && m_show_thd)
+        if (!results.fftfreqs.empty() && m_show_thd)
         {
-            ImPlot::PlotShaded("Fundamental detection", (double*)&m_fftfreqs[m_fft_fund_idx_range_min+1], (double*)&fft_draw[m_fft_fund_idx_range_min+1], m_fft_fund_idx_range_max - m_fft_fund_idx_range_min, -200.0);
+            ImPlot::PlotShaded("Fundamental detection", &fftfreqs[results.fft_fund_idx_range_min+1], &fft_draw[results.fft_fund_idx_range_min+1], results.fft_fund_idx_range_max - results.fft_fund_idx_range_min, -200.0);
             
-            float snr = fft_draw[m_fft_harmonics_idx[0]] - m_noise_foor;
+            float snr = fft_draw[results.fft_harmonics_idx[0]] - results.noise_floor;
 
             char thdtext[64];
-            snprintf(thdtext, 32, "THD : %.3f%%", m_thd);
+            snprintf(thdtext, 32, "THD : %.3f%%", results.thd);
             ImVec2 plotpos = ImPlot::GetPlotPos();
             ImVec2 plotsize = ImPlot::GetPlotSize();
             float plot_to_pix_graph = 140. / plotsize.y;
             ImPlotPoint pnt = ImPlot::PixelsToPlot(ImVec2(plotpos.x + (plotsize.x*0.5), plotpos.y + (plotsize.y*0.05)));
             ImPlot::PlotText(thdtext, pnt.x, pnt.y);
             pnt.y -= 12 * plot_to_pix_graph;
-            snprintf(thdtext, 32, "THD+N : %.3f %% (%.2fdB)", m_thdn, m_thddb);
+            snprintf(thdtext, 32, "THD+N : %.3f %% (%.2fdB)", results.thdn, results.thddb);
+            ImPlot::PlotText(thdtext, pnt.x, pnt.y);
+            pnt.y -= 12 * plot_to_pix_graph;
+            snprintf(thdtext, 64, "THD+N 20-20kHz : %.3f %%  A : %.3f %%", results.thdn_audio_band, results.thdn_a_weighted);
             ImPlot::PlotText(thdtext, pnt.x, pnt.y);
             pnt.y -= 12 * plot_to_pix_graph;
-            snprintf(thdtext, 32, "Total Vrms : %.4f  SNR : %.2fdB", m_fft_rms * m_rms_calibration_scale, snr);
+            snprintf(thdtext, 32, "Total Vrms : %.4f  SNR : %.2fdB", results.fft_rms * m_rms_calibration_scale, snr);
             ImPlot::PlotText(thdtext, pnt.x, pnt.y);
 
-            for (int i = 0; i < m_fft_found_peaks; ++i)
+            for (int i = 0; i < results.fft_found_peaks; ++i)
             {
-                double fund[4] = {m_fft_harmonics_freq[i], m_fft_harmonics_freq[i], 40.0, -200.0};
+                double fund[4] = {results.fft_harmonics_freq[i], results.fft_harmonics_freq[i], 40.0, -200.0};
                 ImPlot::PlotLine("Peaks", fund, fund+2, 2);
-                double y_pos = fft_draw[m_fft_harmonics_idx[i]];
+                double y_pos = fft_draw[results.fft_harmonics_idx[i]];
                 if (!calibration_active)
                 {
                     snprintf(thdtext, 16, "%.4fdB", y_pos);
@@ -690,33 +735,31 @@ void AudioToolWindow::draw_audio_fft_widget(int channelcount, int current_sample
                     double y_pos2 = y_pos + diffdb;
                     snprintf(thdtext, 16, "%.4fdBu", y_pos2);
                 } 
-                ImPlot::PlotText(thdtext, m_fft_harmonics_freq[i], y_pos+40 * plot_to_pix_graph);
-                double freq = m_fftfreqs[m_fft_harmonics_idx[i]] / 1000.0;
+                ImPlot::PlotText(thdtext, results.fft_harmonics_freq[i], y_pos+40 * plot_to_pix_graph);
+                double freq = results.fft_harmonics_freq[i] / 1000.0;
                 snprintf(thdtext, 16, "%.4fKHz", freq);
-                ImPlot::PlotText(thdtext, m_fft_harmonics_freq[i], y_pos+20 * plot_to_pix_graph);
+                ImPlot::PlotText(thdtext, results.fft_harmonics_freq[i], y_pos+20 * plot_to_pix_graph);
             }
         }
 
-        double nf[4] = {0., (current_sample_rate)/2.0, m_noise_foor, m_noise_foor};
+        double nf[4] = {0., (current_sample_rate)/2.0, results.noise_floor, results.noise_floor};
         ImPlot::PlotLine("Noise floor", nf, nf+2, 2);
 
-        double* current_fft_draw = m_fft_channel_left ? m_fftdrawl : m_fftdrawr;
-        
-        if (channelcount>0 && m_fftfreqs)
+        if (channelcount>0 && !results.fftfreqs.empty())
         {
-            if (m_fft_channel_left) ImPlot::PlotLine("Audio left FFT", m_fftfreqs, current_fft_draw, m_sound_data_x.size()/2);
-            if (m_fft_channel_right) ImPlot::PlotLine("Audio right FFT", m_fftfreqs, current_fft_draw, m_sound_data_x.size()/2);
+            if (m_fft_channel_left) ImPlot::PlotLine("Audio left FFT", fftfreqs, fft_draw, results.fftfreqs.size());
+            if (m_fft_channel_right) ImPlot::PlotLine("Audio right FFT", fftfreqs, fft_draw, results.fftfreqs.size());
         }
 
-        double *current_draw = m_fft_channel_left ? m_fftdrawl : m_fftdrawr;
-        if (ImPlot::IsPlotHovered() && m_sound_data_x.size())
+        const double *current_draw = fft_draw;
+        if (ImPlot::IsPlotHovered() && results.fftfreqs.size())
         {
             ImPlotPoint mouse_pos = ImPlot::GetPlotMousePos(IMPLOT_AUTO, ImAxis_Y1);
             char buffer[64];
             int mouse_to_index = 0;
-            for(int i = 0; i < m_sound_data_x.size(); i++)
+            for(int i = 0; i < results.fftfreqs.size(); i++)
             {
-                if (mouse_pos.x < m_fftfreqs[i]) break;
+                if (mouse_pos.x < fftfreqs[i]) break;
                 mouse_to_index = i;
             }
             ImVec2 plotpos = ImPlot::GetPlotPos();
@@ -729,7 +772,7 @@ void AudioToolWindow::draw_audio_fft_widget(int channelcount, int current_sample
     }
 }
 
-void AudioToolWindow::draw_channels_phase_widget(int plotheight)
+void AudioToolWindow::draw_channels_phase_widget(const AnalysisResults& results, int plotheight)
 {
     static float phase_limit_mult = 1.f;
     static float amplitude_limit_mult = 1.f;
@@ -740,7 +783,7 @@ void AudioToolWindow::draw_channels_phase_widget(int plotheight)
         ImPlot::SetupAxis(ImAxis_Y2, "dB", ImPlotAxisFlags_Opposite | ImPlotAxisFlags_NoGridLines);
         ImPlot::SetupAxis(ImAxis_X1, "Time");
 
-        ImPlot::SetupAxesLimits(ImAxis_Y1, m_phase_time.size(), -180.0 * phase_limit_mult, 180.0 * phase_limit_mult, ImPlotCond_Always);
+        ImPlot::SetupAxesLimits(ImAxis_Y1, results.phase_time.size(), -180.0 * phase_limit_mult, 180.0 * phase_limit_mult, ImPlotCond_Always);
         ImPlot::SetupAxisLimits(ImAxis_Y2, -20. * amplitude_limit_mult, 20. * amplitude_limit_mult, ImPlotCond_Always);
 
         if (ImPlot::IsAxisHovered(ImAxis_Y1)){
@@ -757,12 +800,12 @@ void AudioToolWindow::draw_channels_phase_widget(int plotheight)
             if (amplitude_limit_mult > 10) amplitude_limit_mult = 10;
         }
 
-        if (m_phase_time.size())
+        if (results.phase_time.size())
         {
             ImPlot::SetAxes(ImAxis_X1, ImAxis_Y1);
-            ImPlot::PlotLine("L/R phase", &m_phase_time[0], &m_phase_history[0], m_phase_time.size());
+            ImPlot::PlotLine("L/R phase", &results.phase_time[0], &results.phase_history[0], results.phase_time.size());
             ImPlot::SetAxes(ImAxis_X1, ImAxis_Y2);
-            ImPlot::PlotLine("Amplitude diff", &m_phase_time[0], &m_lrdiff_history[0], m_phase_time.size());
+            ImPlot::PlotLine("Amplitude diff", &results.phase_time[0], &results.lrdiff_history[0], results.phase_time.size());
             ImPlot::EndPlot();
         }
     }
@@ -781,6 +824,39 @@ void AudioToolWindow::draw_input_control_widget()
     }
     ImGui::SetItemTooltip("Set the input gain (may not be supported by all devices)");
     ImGui::EndChild();
+
+    ImGui::BeginChild("ScopesChildRecording", ImVec2(0.0f, 0.0f), ImGuiChildFlags_Border | ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_AutoResizeX, ImGuiWindowFlags_None);
+    bool recording = m_analyzer.recording();
+    ImGui::BeginDisabled(!m_compute_on && !recording);
+    if (ImGui::ToggleButton("Record", &recording))
+    {
+        if (recording) m_analyzer.start_recording(m_recording_path);
+        else m_analyzer.stop_recording();
+    }
+    ImGui::EndDisabled();
+    ImGui::SetItemTooltip("Record the input to a WAV file while the analysis is running");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(200);
+    ImGui::BeginDisabled(recording);
+    ImGui::InputText("##RecordingPath", m_recording_path, sizeof(m_recording_path));
+    ImGui::EndDisabled();
+    if (recording)
+    {
+        const CaptureWriter& writer = m_analyzer.capture_writer();
+        ImGui::SameLine();
+        ImGui::Text("%.1fs", writer.captured_time());
+        if (writer.write_error())
+        {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1, 0, 0, 1), "write error");
+        }
+        else if (writer.dropped_frames())
+        {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1, 0, 0, 1), "%llu frames dropped", (unsigned long long)writer.dropped_frames());
+        }
+    }
+    ImGui::EndChild();
     ImGui::EndChild();
 }
 
@@ -841,7 +917,38 @@ void AudioToolWindow::draw_tone_generator_widget()
     }
 }
 
-void AudioToolWindow::draw_rt_analysis_tab()
+void AudioToolWindow::draw_stream_stats_widget(const char* name, StreamStats& stats)
+{
+    const StreamStats::Snapshot s = stats.snapshot();
+    ImGui::SameLine();
+    ImGui::BeginChild(name, ImVec2(0.0f, 0.0f), ImGuiChildFlags_Border | ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_AutoResizeX, ImGuiWindowFlags_None);
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("%s : %llu xruns, %llu dropped frames, max %uus, ring %.1f%%", name,
+                (unsigned long long)(s.input_overflows + s.input_underflows + s.output_overflows + s.output_underflows),
+                (unsigned long long)s.dropped_frames, s.max_duration_us, s.ring_high_water / 10.f);
+    if (ImGui::BeginItemTooltip())
+    {
+        ImGui::Text("Callbacks : %llu (%llu frames)", (unsigned long long)s.callbacks, (unsigned long long)s.frames);
+        ImGui::Text("Input overflows : %llu, underflows : %llu", (unsigned long long)s.input_overflows, (unsigned long long)s.input_underflows);
+        ImGui::Text("Output underflows : %llu, overflows : %llu", (unsigned long long)s.output_underflows, (unsigned long long)s.output_overflows);
+        ImGui::Text("Ring high water : %.1f%%", s.ring_high_water / 10.f);
+        ImGui::Separator();
+        ImGui::Text("Callback time / deadline");
+        for (int i = 0; i < StreamStats::HISTOGRAM_BINS; ++i)
+        {
+            const double bound = StreamStats::HISTOGRAM_BOUNDS[std::min(i, StreamStats::HISTOGRAM_BINS - 2)] * 100.;
+            ImGui::Text("%s %3.0f%% : %llu", i < StreamStats::HISTOGRAM_BINS - 1 ? "<=" : "> ", bound, (unsigned long long)s.histogram[i]);
+        }
+        ImGui::EndTooltip();
+    }
+    ImGui::SameLine();
+    ImGui::PushID(name);
+    if (ImGui::SmallButton("Reset")) stats.reset();
+    ImGui::PopID();
+    ImGui::EndChild();
+}
+
+void AudioToolWindow::draw_rt_analysis_tab(const AnalysisResults& results)
 {
     int channelcount = m_audiorecorder.get_channel_count(); 
     float current_sample_rate = m_audiorecorder.get_current_samplerate();
@@ -939,7 +1046,7 @@ void AudioToolWindow::draw_rt_analysis_tab()
         if (ImGui::Button("Calibrate from left"))
         {
 
-            m_rms_calibration_scale = rms_calibration / m_rms_left;
+            m_rms_calibration_scale = rms_calibration / results.rms_left;
         }
         ImGui::SetItemTooltip("Do the calibration from left channel");
         if (channelcount > 1)
@@ -948,7 +1055,7 @@ void AudioToolWindow::draw_rt_analysis_tab()
             ImGui::SetNextItemWidth(70);
             if (ImGui::Button("Calibrate from right"))
             {
-                m_rms_calibration_scale = rms_calibration / m_rms_right;
+                m_rms_calibration_scale = rms_calibration / results.rms_right;
             }
             ImGui::SetItemTooltip("Do the calibration from right channel");
         }
@@ -971,7 +1078,7 @@ void AudioToolWindow::draw_rt_analysis_tab()
         ImGui::SameLine();
         ImGui::BeginChild("ScopesChildComputeInfo", ImVec2(0.0f, 0.0f), ImGuiChildFlags_Border | ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_AutoResizeX, ImGuiWindowFlags_None);
         ImGui::AlignTextToFramePadding();
-        ImGui::Text("Audio process time: %05luns", m_total_compute_time);
+        ImGui::Text("Audio process time: %05luns", results.compute_time);
         ImGui::EndChild();
 
         ImGui::SameLine();
@@ -985,16 +1092,21 @@ void AudioToolWindow::draw_rt_analysis_tab()
         ImGui::AlignTextToFramePadding();
         ImGui::Text("Record buffer : %.1f%%", m_audiorecorder.get_ringbuffer_occupation());
         ImGui::EndChild();
+
+        // Callback deadline and xrun counters, hover for the details
+        draw_stream_stats_widget("Input", m_audiorecorder.get_stats());
+        draw_stream_stats_widget("Generator", m_signal_generator.get_stats());
+        if (m_audio_loopback_on) draw_stream_stats_widget("Loopback", m_audioloopback.get_stats());
     }
     /*
     *   LCD voltmeter
     */
     if (m_show_rms_voltage)
     {
-        draw_voltmeter_widget(channelcount);
+        draw_voltmeter_widget(results, channelcount);
     }
 
-    draw_audio_time_domain_widget(plotheight, current_sample_rate, channelcount);
+    draw_audio_time_domain_widget(results, plotheight, current_sample_rate, channelcount);
     
     ImGui::SameLine();
     if (m_show_wow_flutter)
@@ -1020,10 +1132,41 @@ void AudioToolWindow::draw_rt_analysis_tab()
     ImGui::SetNextItemWidth(150);
     if (ImGui::Combo("Window mode", &m_fft_window_fn_index, vector_getter, (void *)&m_wmodes, m_wmodes.size()))
     {
-        set_window_fn();
+        m_analyzer.set_window_fn(m_fft_window_fn_index);
     }
     ImGui::SetItemTooltip("Set the FFT windowing mode");
     ImGui::EndChild();
+
+    ImGui::SameLine();
+    ImGui::BeginChild("ScopesChildFFTOverlap", ImVec2(0.0f, 0.0f), ImGuiChildFlags_Border | ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_AutoResizeX, ImGuiWindowFlags_None);
+    ImGui::SetNextItemWidth(80);
+    ImGui::Combo("Overlap", &m_fft_overlap_index, vector_getter, (void *)&m_overlap_modes, m_overlap_modes.size());
+    ImGui::SetItemTooltip("Overlap between consecutive analysis windows, higher values update faster at the same FFT size");
+    ImGui::EndChild();
+
+    ImGui::SameLine();
+    ImGui::BeginChild("ScopesChildFFTAverage", ImVec2(0.0f, 0.0f), ImGuiChildFlags_Border | ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_AutoResizeX, ImGuiWindowFlags_None);
+    ImGui::SetNextItemWidth(110);
+    ImGui::Combo("Average", &m_fft_average_mode, vector_getter, (void *)&m_average_modes, m_average_modes.size());
+    ImGui::SetItemTooltip("Power spectrum averaging, used by the FFT plot and the THD/THD+N measurements, off during sweeps");
+    if (m_fft_average_mode != SpectrumAverager::NONE)
+    {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(80);
+        if (ImGui::InputInt("N", &m_fft_average_count, 1, 4))
+        {
+            m_fft_average_count = std::min(std::max(m_fft_average_count, 1), 256);
+        }
+        ImGui::SetItemTooltip("Number of averaged spectra (time constant in exponential mode)");
+        ImGui::SameLine();
+        if (ImGui::Button("Reset"))
+        {
+            m_analyzer.reset_average();
+        }
+        ImGui::SameLine();
+        ImGui::Text("%i", results.average_count);
+    }
+    ImGui::EndChild();
     ImGui::SameLine();
     if (channelcount > 1)
     {
@@ -1062,11 +1205,11 @@ void AudioToolWindow::draw_rt_analysis_tab()
 
     ImGui::EndChild();
 
-    draw_audio_fft_widget(channelcount, current_sample_rate, plotheight);
+    draw_audio_fft_widget(results, channelcount, current_sample_rate, plotheight);
 
     if (m_compute_channel_phase)
     {
-        draw_channels_phase_widget(plotheight);
+        draw_channels_phase_widget(results, plotheight);
     }
 
     ImGui::EndChild();
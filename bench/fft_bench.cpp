@@ -0,0 +1,108 @@
+/*
+ * Stereo FFT benchmark, for each capture size compare :
+ *  - two r2c plans (one per channel)
+ *  - one plan_many r2c plan transforming both channels
+ *  - one c2c plan, left in the real part, right in the imaginary part, spectra separated afterwards
+ */
+#define _USE_MATH_DEFINES
+#include <fftw3.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static const int ITERATIONS = 200;
+
+template<class F>
+static double time_ns(F fn)
+{
+    fn();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) fn();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / ITERATIONS;
+}
+
+// X[k] = (Z[k] + conj(Z[N-k])) / 2, Y[k] = (Z[k] - conj(Z[N-k])) / 2i
+static void separate_spectra(const fftw_complex* z, int n, fftw_complex* left, fftw_complex* right)
+{
+    const int bins = n / 2 + 1;
+    for (int k = 0; k < bins; ++k)
+    {
+        const int nk = k == 0 ? 0 : n - k;
+        double re = z[k][0], im = z[k][1];
+        double cre = z[nk][0], cim = -z[nk][1];
+        left[k][0] = 0.5 * (re + cre);
+        left[k][1] = 0.5 * (im + cim);
+        right[k][0] = 0.5 * (im - cim);
+        right[k][1] = -0.5 * (re - cre);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int sizes[] = {4096, 4410, 4800, 8192, 9600, 19200, 48000};
+    unsigned flags = (argc > 1 && argv[1][0] == 'm') ? FFTW_MEASURE : FFTW_ESTIMATE;
+
+    printf("%-8s %-14s %-14s %-14s %-10s\n", "size", "2 x r2c ns", "plan_many ns", "packed ns", "max err");
+    for (int n : sizes)
+    {
+        const int bins = n / 2 + 1;
+        double* in = fftw_alloc_real(2 * n);
+        fftw_complex* out = fftw_alloc_complex(2 * bins);
+        fftw_complex* packed_in = fftw_alloc_complex(n);
+        fftw_complex* packed_out = fftw_alloc_complex(n);
+        fftw_complex* sep = fftw_alloc_complex(2 * bins);
+
+        fftw_plan left = fftw_plan_dft_r2c_1d(n, in, out, flags);
+        fftw_plan right = fftw_plan_dft_r2c_1d(n, in + n, out + bins, flags);
+        fftw_plan many = fftw_plan_many_dft_r2c(1, &n, 2, in, NULL, 1, n, out, NULL, 1, bins, flags);
+        fftw_plan packed = fftw_plan_dft_1d(n, packed_in, packed_out, FFTW_FORWARD, flags);
+
+        for (int i = 0; i < n; ++i)
+        {
+            in[i] = sin(2.0 * M_PI * 1000.0 * i / 48000.0) + 0.001 * (rand() / (double)RAND_MAX);
+            in[n + i] = 0.5 * sin(2.0 * M_PI * 3150.0 * i / 48000.0);
+        }
+
+        double two_plans = time_ns([&](){
+            fftw_execute(left);
+            fftw_execute(right);
+        });
+        double plan_many = time_ns([&](){
+            fftw_execute(many);
+        });
+        double packed_ns = time_ns([&](){
+            for (int i = 0; i < n; ++i)
+            {
+                packed_in[i][0] = in[i];
+                packed_in[i][1] = in[n + i];
+            }
+            fftw_execute(packed);
+            separate_spectra(packed_out, n, sep, sep + bins);
+        });
+
+        // Check the packed path against the reference
+        fftw_execute(many);
+        double max_err = 0;
+        for (int k = 0; k < 2 * bins; ++k)
+        {
+            max_err = fmax(max_err, fabs(out[k][0] - sep[k][0]));
+            max_err = fmax(max_err, fabs(out[k][1] - sep[k][1]));
+        }
+
+        printf("%-8d %-14.0f %-14.0f %-14.0f %-10.2e\n", n, two_plans, plan_many, packed_ns, max_err);
+
+        fftw_destroy_plan(left);
+        fftw_destroy_plan(right);
+        fftw_destroy_plan(many);
+        fftw_destroy_plan(packed);
+        fftw_free(in);
+        fftw_free(out);
+        fftw_free(packed_in);
+        fftw_free(packed_out);
+        fftw_free(sep);
+    }
+
+    return 0;
+}
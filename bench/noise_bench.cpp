@@ -0,0 +1,138 @@
+/*
+ * Noise generator benchmark, cost of one audio callback at 192kHz stereo :
+ *  - the former per sample path, a virtual sample() call and a mode branch per frame
+ *  - the block generators of noise.h rendering a GENERATOR_BLOCK_SIZE block then interleaving
+ * Reported as a fraction of the callback deadline (frames / samplerate)
+ */
+#include <noise.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static const int SAMPLERATE = 192000;
+static const int CHANNELS = 2;
+static const int BLOCK_SIZE = 256;
+static const int CALLBACKS = 20000;
+
+// Former per sample generators
+class LegacyNoise {
+    uint64_t u, v, w;
+public:
+    LegacyNoise(){
+        v = 4101842887655102017LL; w = 1; u = 1ULL ^ v; next(); v = u; next(); w = v; next();
+    }
+    virtual ~LegacyNoise(){}
+    virtual double sample() = 0;
+    uint64_t next(){
+        u = u * 2862933555777941757LL + 7046029254386353087LL;
+        v ^= v >> 17; v ^= v << 31; v ^= v >> 8;
+        w = 4294957665U*(w & 0xffffffff) + (w >> 32);
+        uint64_t x = u ^ (u << 21); x ^= x >> 35; x ^= x << 4;
+        return (x + v) ^ w;
+    }
+    double white(){return 2.0 * 5.42101086242752217E-20 * next() - 1.0;}
+};
+
+class LegacyWhite : public LegacyNoise {
+public:
+    double sample() override {return white();}
+};
+
+class LegacyPink : public LegacyNoise {
+    double b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0;
+public:
+    double sample() override {
+        double x = white();
+        b0 = 0.99886 * b0 + x * 0.0555179; b1 = 0.99332 * b1 + x * 0.0750759;
+        b2 = 0.96900 * b2 + x * 0.1538520; b3 = 0.86650 * b3 + x * 0.3104856;
+        b4 = 0.55000 * b4 + x * 0.5329522; b5 = -0.7616 * b5 - x * 0.0168980;
+        double pink = b0 + b1 + b2 + b3 + b4 + b5 + b6 + x * 0.5362;
+        b6 = x * 0.115926;
+        return pink * 0.11;
+    }
+};
+
+template<class F>
+static double callback_seconds(F fn)
+{
+    for (int i = 0; i < 100; ++i) fn();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLBACKS; ++i) fn();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count() / CALLBACKS;
+}
+
+static void report(const char* name, int frames, double seconds)
+{
+    const double deadline = double(frames) / SAMPLERATE;
+    printf("%-24s %6d frames  %8.2f us / %8.1f us deadline  %6.3f%% load\n",
+           name, frames, seconds * 1e6, deadline * 1e6, seconds / deadline * 100.);
+}
+
+int main(int, char**)
+{
+    const int callback_sizes[] = {64, 256, 1024};
+    volatile int mode = 3;
+
+    for (int frames : callback_sizes)
+    {
+        std::vector<float> output(frames * CHANNELS);
+        float block[BLOCK_SIZE];
+
+        LegacyWhite legacy_white;
+        LegacyPink legacy_pink;
+        auto legacy = [&](LegacyNoise& noise) {
+            return callback_seconds([&]() {
+                float* data = output.data();
+                for (int i = 0; i < frames; ++i)
+                {
+                    double sample = 0;
+                    if (mode <= 2) sample = 0;
+                    else sample = noise.sample();
+                    for (int c = 0; c < CHANNELS; ++c) *data++ = (float)sample;
+                }
+            });
+        };
+
+        WhiteNoiseGenerator white;
+        BrownNoiseGenerator brown;
+        PinkNoiseGenerator pink;
+        auto blocks = [&](NoiseGeneratorBase& noise) {
+            return callback_seconds([&]() {
+                float* data = output.data();
+                for (int done = 0; done < frames;)
+                {
+                    const int count = std::min(frames - done, BLOCK_SIZE);
+                    noise.render(block, count);
+                    for (int i = 0; i < count; ++i)
+                        for (int c = 0; c < CHANNELS; ++c) *data++ = block[i];
+                    done += count;
+                }
+            });
+        };
+
+        report("white, per sample", frames, legacy(legacy_white));
+        report("white, block", frames, blocks(white));
+        report("brown, block", frames, blocks(brown));
+        report("pink, per sample", frames, legacy(legacy_pink));
+        report("pink, block", frames, blocks(pink));
+        printf("\n");
+    }
+
+    // Distribution check of the counter based generator, uniform on [-1, 1)
+    WhiteNoiseGenerator white;
+    std::vector<float> samples(1 << 22);
+    white.render(samples.data(), samples.size());
+    double mean = 0, power = 0, lag = 0;
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        mean += samples[i];
+        power += samples[i] * samples[i];
+        if (i) lag += samples[i] * samples[i - 1];
+    }
+    printf("white : mean %.5f, rms %.5f (uniform %.5f), lag 1 correlation %.5f\n",
+           mean / samples.size(), sqrt(power / samples.size()), 1. / sqrt(3.), lag / power);
+    return 0;
+}
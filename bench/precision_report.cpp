@@ -0,0 +1,125 @@
+/*
+ * Single vs double precision FFT accuracy report
+ * A 997 Hz tone with known harmonics and white noise goes through the analyzer front end
+ * (capture kernel, Hann window, r2c FFT, power spectrum) with fftw and fftwf,
+ * THD and THD+N are computed the same way as AudioAnalyzer and compared
+ */
+#define _USE_MATH_DEFINES
+#include <fftw3.h>
+#include <dsp_kernels.h>
+#include <spectrum_averager.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+static const int SAMPLERATE = 48000;
+static const int CAPTURE_SIZE = 48000;
+static const double FUNDAMENTAL = 997.0;
+static const int HARMONICS = 8;
+// Bins around the fundamental excluded from THD+N, wider than the Hann main lobe
+static const int FUNDAMENTAL_SPAN = 3;
+
+struct Distortion
+{
+    double thd;
+    double thdn;
+};
+
+static Distortion analyze(const double* power, int bins)
+{
+    const int fundamental = (int)lround(FUNDAMENTAL * CAPTURE_SIZE / SAMPLERATE);
+
+    double harmonics = 0;
+    for (int i = 2; i <= HARMONICS && fundamental * i < bins; ++i) harmonics += power[fundamental * i];
+
+    double total = 0, fundamental_power = 0;
+    for (int i = 1; i < bins; ++i)
+    {
+        if (abs(i - fundamental) <= FUNDAMENTAL_SPAN) fundamental_power += power[i];
+        else total += power[i];
+    }
+
+    Distortion d;
+    d.thd = sqrt(harmonics / power[fundamental]) * 100.;
+    d.thdn = sqrt(total / (total + fundamental_power)) * 100.;
+    return d;
+}
+
+static double db_diff(double a, double b)
+{
+    return fabs(20.0 * log10(a / b));
+}
+
+int main(int, char**)
+{
+    const int bins = CAPTURE_SIZE / 2 + 1;
+    const double harmonic_levels_db[] = {-40, -60, -80, -100, -120, -140};
+    const double noise_levels_db[] = {-60, -90, -120, -140};
+
+    std::vector<float> capture(CAPTURE_SIZE);
+    std::vector<double> window(CAPTURE_SIZE), out(CAPTURE_SIZE), windowed(CAPTURE_SIZE);
+    std::vector<float> windowf(CAPTURE_SIZE), windowedf(CAPTURE_SIZE);
+    for (int i = 0; i < CAPTURE_SIZE; ++i)
+    {
+        window[i] = 0.5 * (1.0 - cos(2.0 * M_PI * i / CAPTURE_SIZE));
+        windowf[i] = window[i];
+    }
+
+    fftw_complex* spectrum = fftw_alloc_complex(bins);
+    fftwf_complex* spectrumf = fftwf_alloc_complex(bins);
+    fftw_plan plan = fftw_plan_dft_r2c_1d(CAPTURE_SIZE, windowed.data(), spectrum, FFTW_ESTIMATE);
+    fftwf_plan planf = fftwf_plan_dft_r2c_1d(CAPTURE_SIZE, windowedf.data(), spectrumf, FFTW_ESTIMATE);
+
+    SpectrumAverager average, averagef;
+    average.init(bins);
+    averagef.init(bins);
+
+    std::mt19937 rng(1234);
+    printf("%-10s %-10s %-12s %-12s %-10s %-12s %-12s %-10s\n",
+           "harm dBc", "noise dB", "THD f64 %", "THD f32 %", "diff dB", "THD+N f64 %", "THD+N f32 %", "diff dB");
+
+    for (double noise_db : noise_levels_db)
+    {
+        for (double harmonic_db : harmonic_levels_db)
+        {
+            // The capture stays float, as delivered by the sound card
+            std::normal_distribution<double> noise(0.0, pow(10.0, noise_db / 20.0));
+            const double harmonic_amplitude = 0.5 * pow(10.0, harmonic_db / 20.0);
+            for (int i = 0; i < CAPTURE_SIZE; ++i)
+            {
+                double phase = 2.0 * M_PI * FUNDAMENTAL * i / SAMPLERATE;
+                double s = 0.5 * sin(phase);
+                for (int h = 2; h <= HARMONICS; ++h) s += harmonic_amplitude * sin(h * phase);
+                capture[i] = (float)(s + noise(rng));
+            }
+
+            double sumsq[2] = {0, 0};
+            deinterleave_capture(capture.data(), CAPTURE_SIZE, 1, 1.0, window.data(),
+                                 out.data(), nullptr, windowed.data(), nullptr, sumsq);
+            sumsq[0] = 0;
+            deinterleave_capture(capture.data(), CAPTURE_SIZE, 1, 1.0, windowf.data(),
+                                 out.data(), nullptr, windowedf.data(), nullptr, sumsq);
+
+            fftw_execute(plan);
+            fftwf_execute(planf);
+            average.add((const double*)spectrum);
+            averagef.add((const float*)spectrumf);
+
+            Distortion d = analyze(average.power(), bins);
+            Distortion f = analyze(averagef.power(), bins);
+            printf("%-10.0f %-10.0f %-12.6f %-12.6f %-10.4f %-12.6f %-12.6f %-10.4f\n",
+                   harmonic_db, noise_db, d.thd, f.thd, db_diff(d.thd, f.thd), d.thdn, f.thdn, db_diff(d.thdn, f.thdn));
+        }
+    }
+
+    average.destroy();
+    averagef.destroy();
+    fftw_destroy_plan(plan);
+    fftwf_destroy_plan(planf);
+    fftw_free(spectrum);
+    fftwf_free(spectrumf);
+
+    return 0;
+}
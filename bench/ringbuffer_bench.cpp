@@ -0,0 +1,126 @@
+/*
+ * Ring buffer microbenchmark : IringBuffer vs SpscRingBuffer
+ * A producer thread pushes audio sized blocks while the consumer drains them,
+ * reports the time per transferred element.
+ */
+#include <ringbuffer.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+// Touch every element the consumer gets, same work for all variants
+static uint32_t consume(const float* data, size_t size)
+{
+    uint32_t hash = 0;
+    const uint32_t* bits = (const uint32_t*)data;
+    for (size_t i = 0; i < size; ++i) hash ^= bits[i];
+    return hash;
+}
+
+static const size_t RING_SIZE = 16384;
+static const size_t TOTAL_ELEMENTS = 1 << 26;
+
+template<class Buffer>
+static double run_threaded(Buffer& rb, size_t block_size)
+{
+    std::vector<float> in(block_size, 1.0f), out(block_size);
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread producer([&](){
+        size_t written = 0;
+        while (written < TOTAL_ELEMENTS)
+        {
+            if (rb.getWriteAvailable() < block_size)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            written += rb.write(in.data(), block_size);
+        }
+    });
+
+    size_t read = 0;
+    uint32_t hash = 0;
+    while (read < TOTAL_ELEMENTS)
+    {
+        if (rb.getReadAvailable() < block_size)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        read += rb.read(out.data(), block_size);
+        hash ^= consume(out.data(), block_size);
+    }
+    producer.join();
+
+    auto stop = std::chrono::steady_clock::now();
+    if (hash) printf("Data mismatch %08x\n", hash);
+    return std::chrono::duration<double, std::nano>(stop - start).count() / double(TOTAL_ELEMENTS);
+}
+
+static double run_peek_commit(SpscRingBuffer& rb, size_t block_size)
+{
+    std::vector<float> in(block_size, 1.0f);
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread producer([&](){
+        size_t written = 0;
+        SpscRingBuffer::Regions regions;
+        while (written < TOTAL_ELEMENTS)
+        {
+            if (rb.peek_write(block_size, regions) < block_size)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            memcpy(regions.data1, in.data(), regions.size1 * sizeof(float));
+            if (regions.size2) memcpy(regions.data2, in.data() + regions.size1, regions.size2 * sizeof(float));
+            rb.commit_write(block_size);
+            written += block_size;
+        }
+    });
+
+    // Consumer works in place, no copy out of the ring
+    size_t read = 0;
+    uint32_t hash = 0;
+    SpscRingBuffer::Regions regions;
+    while (read < TOTAL_ELEMENTS)
+    {
+        if (rb.peek_read(block_size, regions) < block_size)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        hash ^= consume((const float*)regions.data1, regions.size1);
+        hash ^= consume((const float*)regions.data2, regions.size2);
+        rb.commit_read(block_size);
+        read += block_size;
+    }
+    producer.join();
+
+    auto stop = std::chrono::steady_clock::now();
+    if (hash) printf("Data mismatch %08x\n", hash);
+    return std::chrono::duration<double, std::nano>(stop - start).count() / double(TOTAL_ELEMENTS);
+}
+
+int main(int argc, char** argv)
+{
+    const size_t block_sizes[] = {64, 256, 1024, 4096};
+
+    printf("%-8s %-18s %-18s %-18s\n", "block", "IringBuffer ns/el", "Spsc ns/el", "Spsc peek ns/el");
+    for (size_t block_size : block_sizes)
+    {
+        ringBuffer<float> legacy(RING_SIZE);
+        spscRingBuffer<float> spsc(RING_SIZE);
+        spscRingBuffer<float> spsc_peek(RING_SIZE);
+
+        double legacy_ns = run_threaded(legacy, block_size);
+        double spsc_ns = run_threaded(spsc, block_size);
+        double peek_ns = run_peek_commit(spsc_peek, block_size);
+
+        printf("%-8zu %-18.3f %-18.3f %-18.3f\n", block_size, legacy_ns, spsc_ns, peek_ns);
+    }
+
+    return 0;
+}
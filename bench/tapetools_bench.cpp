@@ -0,0 +1,293 @@
+/*
+ * Analysis hot paths benchmark, time per analysis block for each samplerate and capture time :
+ *  - the capture kernel (deinterleave, gain, window)
+ *  - the stereo FFT and the power spectrum
+ *  - THD and THD+N (HarmonicAnalysis)
+ *  - the wow & flutter demodulator and the libdsp cascades it runs
+ *  - the Savitzky-Golay smoothing of a spectrum
+ *  - the whole AudioAnalyzer::process() fed by a pre-rendered synthetic signal
+ *  - the RTL-SDR scanner fixed point FFT when built WITH_RTLSDR
+ * The result is printed as JSON, the block budget is the audio time of one block
+ * Usage : tapetools_bench [iterations]
+ */
+#define _USE_MATH_DEFINES
+#include <fftw3.h>
+#include <utils.h>
+#include <dsp_kernels.h>
+#include <harmonic_analysis.h>
+#include <audio_source.h>
+#include <Dsp.h>
+#include "audio_analyzer.h"
+#include "wow_flutter_stream.h"
+#ifdef RTL_SDR
+#include <scanner.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+void log_message(const char* format, ...){}
+
+static const int SAMPLERATES[] = {44100, 48000, 96000, 192000};
+// Capture times of the UI, the FFT size is samplerate * time
+static const int CAPTURE_TIMES_MS[] = {100, 200, 500};
+static const int WOW_REFERENCE = 3150;
+
+struct Timing
+{
+    double mean_us = 0;
+    double min_us = 0;
+};
+
+template<class F>
+static Timing time_block(int iterations, F fn)
+{
+    fn();
+    Timing timing;
+    timing.min_us = 1e30;
+    double total = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        total += us;
+        timing.min_us = std::min(timing.min_us, us);
+    }
+    timing.mean_us = total / iterations;
+    return timing;
+}
+
+/*
+ * Source looping over a pre-rendered signal, handed out in place like the recorder ring :
+ * the analyzer is timed without the signal synthesis
+ */
+class LoopedAudioSource : public AudioSource
+{
+    std::vector<float>  m_data;
+    size_t              m_read_pos = 0;
+    int                 m_samplerate;
+    int                 m_channels;
+
+public:
+    LoopedAudioSource(RenderedAudioSource& source, int frames)
+        : m_samplerate(source.get_current_samplerate()), m_channels(source.get_channel_count())
+    {
+        const size_t size = size_t(frames) * m_channels;
+        SpscRingBuffer::Regions regions;
+        if (source.peek_data(size, regions)) m_data.assign((float*)regions.data1, (float*)regions.data1 + size);
+    }
+
+    int  get_available_samples() override {return INT_MAX;}
+    bool peek_data(size_t size, SpscRingBuffer::Regions& regions) override
+    {
+        if (size > m_data.size()) return false;
+        regions.size1 = std::min(size, m_data.size() - m_read_pos);
+        regions.data1 = m_data.data() + m_read_pos;
+        regions.size2 = size - regions.size1;
+        regions.data2 = regions.size2 ? m_data.data() : nullptr;
+        return true;
+    }
+    void consume_data(size_t size) override {m_read_pos = (m_read_pos + size) % m_data.size();}
+    bool is_floatingpoint() override {return true;}
+    int  get_current_samplerate() override {return m_samplerate;}
+    int  get_channel_count() override {return m_channels;}
+    bool pause(bool) override {return true;}
+};
+
+static void print_timing(const char* name, const Timing& timing, bool last = false)
+{
+    printf("        \"%s\": {\"mean_us\": %.3f, \"min_us\": %.3f}%s\n", name, timing.mean_us, timing.min_us, last ? "" : ",");
+}
+
+static void bench_config(int samplerate, int capture_ms, int iterations, bool last)
+{
+    const int size = samplerate * capture_ms / 1000;
+    const int bins = size / 2 + 1;
+
+    // 1kHz with a little distortion and noise on the left, the W&F reference on the right
+    std::vector<float> interleaved(size * 2);
+    std::vector<double> carrier(size);
+    for (int i = 0; i < size; ++i)
+    {
+        const double t = double(i) / samplerate;
+        const double left = 0.5 * sin(2. * M_PI * 1000. * t) + 0.0005 * sin(2. * M_PI * 2000. * t) + 1e-5 * (rand() / (double)RAND_MAX - 0.5);
+        carrier[i] = 0.5 * sin(2. * M_PI * WOW_REFERENCE * t + 0.01 * sin(2. * M_PI * 4. * t));
+        interleaved[2 * i] = left;
+        interleaved[2 * i + 1] = carrier[i];
+    }
+
+    std::vector<double> window(size), out_l(size), out_r(size);
+    double window_power = 0;
+    for (int i = 0; i < size; ++i)
+    {
+        window[i] = hann_fft_window(i, size);
+        window_power += window[i] * window[i];
+    }
+
+    double* fft_in = fftw_alloc_real(2 * size);
+    fftw_complex* fft_out = fftw_alloc_complex(2 * bins);
+    fftw_plan plan = fftw_plan_many_dft_r2c(1, &size, 2, fft_in, NULL, 1, size, fft_out, NULL, 1, bins, FFTW_ESTIMATE);
+    std::vector<double> power(2 * bins);
+
+    const Timing deinterleave = time_block(iterations, [&](){
+        double sumsq[2] = {0, 0};
+        deinterleave_capture(interleaved.data(), size, 2, 1.0, window.data(), out_l.data(), out_r.data(), fft_in, fft_in + size, sumsq);
+    });
+
+    const Timing fft = time_block(iterations, [&](){
+        fftw_execute(plan);
+        for (int i = 0; i < 2 * bins; ++i) power[i] = fft_out[i][0] * fft_out[i][0] + fft_out[i][1] * fft_out[i][1];
+    });
+
+    PeakInterpolator interpolator;
+    interpolator.init(hann_fft_window);
+    HarmonicAnalysis harmonics;
+    SpectrumIntegrator spectrum;
+    spectrum.init(bins - 1, double(samplerate) / size);
+    const Timing thd = time_block(iterations, [&](){
+        harmonics.compute_thd(power.data(), bins - 1, double(samplerate) / size, interpolator);
+    });
+    const Timing thdn = time_block(iterations, [&](){
+        harmonics.compute_thdn(power.data(), bins - 1, size / window_power, spectrum);
+    });
+
+    std::vector<double> smoothed(bins);
+    const Timing smooth = time_block(iterations, [&](){
+        sg_smooth(power.data(), smoothed.data(), bins, 8, 2);
+    });
+
+    WowFlutterStream stream;
+    stream.init(samplerate, WOW_FLUTTER_DECIMATION, int(WOW_FLUTTER_ANALYSIS_TIME * samplerate) / WOW_FLUTTER_DECIMATION);
+    stream.configure(WOW_REFERENCE, 0);
+    const Timing wow_flutter = time_block(iterations, [&](){
+        stream.process(carrier.data(), size);
+    });
+
+    // The W&F cascades alone, with their realtime setup, the IQ low-pass runs on the decimated rate
+    Dsp::SimpleFilter <Dsp::ChebyshevI::BandPass <4>, 1> prefilter;
+    Dsp::SimpleFilter <Dsp::ChebyshevI::LowPass <4>, 2> iq_lowpass;
+    prefilter.setup(4, samplerate, WOW_REFERENCE, 500, 0.2);
+    iq_lowpass.setup(4, samplerate / WOW_FLUTTER_DECIMATION, 700, 0.1);
+    std::vector<double> filtered(size), signal_i(size / WOW_FLUTTER_DECIMATION), signal_q(size / WOW_FLUTTER_DECIMATION, 0.);
+    const Timing bandpass = time_block(iterations, [&](){
+        std::copy(carrier.begin(), carrier.end(), filtered.begin());
+        double* channels[1] = {filtered.data()};
+        prefilter.process(size, channels);
+    });
+    const Timing lowpass = time_block(iterations, [&](){
+        for (size_t i = 0; i < signal_i.size(); ++i) signal_i[i] = carrier[i * WOW_FLUTTER_DECIMATION];
+        double* channels[2] = {signal_i.data(), signal_q.data()};
+        iq_lowpass.process(signal_i.size(), channels);
+    });
+
+    // Whole block, as the analysis thread runs it with THD and W&F enabled
+    // One second holds whole carrier and wow cycles, the loop is seamless
+    SyntheticSignal signal;
+    signal.samplerate = samplerate;
+    signal.frequency = WOW_REFERENCE;
+    signal.harmonics_db = {-60, -70};
+    signal.noise_db = -100;
+    signal.wow_frequency = 4;
+    signal.wow_depth = 0.1;
+    SyntheticAudioSource synthetic(signal);
+    LoopedAudioSource source(synthetic, samplerate);
+    AudioAnalyzer analyzer(source);
+    analyzer.init_capture(size, samplerate, false);
+    AnalysisSettings settings;
+    settings.compute_on = true;
+    settings.show_thd = true;
+    settings.show_wow_flutter = true;
+    settings.wow_reference_frequency = WOW_REFERENCE;
+    analyzer.set_settings(settings);
+    const Timing process = time_block(iterations, [&](){
+        analyzer.process();
+    });
+    analyzer.destroy_capture();
+
+    fftw_destroy_plan(plan);
+    fftw_free(fft_in);
+    fftw_free(fft_out);
+
+    const double budget_us = 1e6 * size / samplerate;
+    printf("    {\n");
+    printf("      \"samplerate\": %i,\n", samplerate);
+    printf("      \"fft_size\": %i,\n", size);
+    printf("      \"block_budget_us\": %.1f,\n", budget_us);
+    printf("      \"process_budget_fraction\": %.6f,\n", process.mean_us / budget_us);
+    printf("      \"stages\": {\n");
+    print_timing("deinterleave_window", deinterleave);
+    print_timing("fft_power", fft);
+    print_timing("compute_thd", thd);
+    print_timing("compute_thdn", thdn);
+    print_timing("sg_smooth", smooth);
+    print_timing("wow_flutter_stream", wow_flutter);
+    print_timing("cheby1_bandpass4", bandpass);
+    print_timing("cheby1_lowpass4_iq", lowpass);
+    print_timing("analyzer_process", process, true);
+    printf("      }\n");
+    printf("    }%s\n", last ? "" : ",");
+}
+
+#ifdef RTL_SDR
+/*
+ * Fixed point FFT of the scanner, interleaved int16 IQ transformed in place
+ */
+class ScannerBenchmark
+{
+public:
+    static void run(int iterations)
+    {
+        SDR_Scanner scanner;
+        printf("  \"fix_fft\": [");
+        for (int log2_size = 10; log2_size <= 14; ++log2_size)
+        {
+            const int size = 1 << log2_size;
+            scanner.make_sine_table(log2_size);
+            std::vector<int16_t> source(2 * size), iq(2 * size);
+            for (int i = 0; i < size; ++i)
+            {
+                source[2 * i] = int16_t(8000 * cos(2. * M_PI * 37. * i / size));
+                source[2 * i + 1] = int16_t(8000 * sin(2. * M_PI * 37. * i / size));
+            }
+            const Timing timing = time_block(iterations, [&](){
+                std::copy(source.begin(), source.end(), iq.begin());
+                scanner.fix_fft(iq.data(), log2_size);
+            });
+            free(scanner.m_sinewave);
+            scanner.m_sinewave = nullptr;
+            printf("%s\n    {\"size\": %i, \"mean_us\": %.3f, \"min_us\": %.3f}", log2_size > 10 ? "," : "", size, timing.mean_us, timing.min_us);
+        }
+        printf("\n  ],\n");
+    }
+};
+#endif
+
+int main(int argc, char** argv)
+{
+    const int iterations = argc > 1 ? std::max(atoi(argv[1]), 1) : 50;
+
+    printf("{\n");
+    printf("  \"iterations\": %i,\n", iterations);
+#ifdef RTL_SDR
+    ScannerBenchmark::run(iterations);
+#endif
+    printf("  \"configs\": [\n");
+    const int samplerate_count = sizeof(SAMPLERATES) / sizeof(SAMPLERATES[0]);
+    const int capture_count = sizeof(CAPTURE_TIMES_MS) / sizeof(CAPTURE_TIMES_MS[0]);
+    for (int s = 0; s < samplerate_count; ++s)
+    {
+        for (int c = 0; c < capture_count; ++c)
+        {
+            bench_config(SAMPLERATES[s], CAPTURE_TIMES_MS[c], iterations, s == samplerate_count - 1 && c == capture_count - 1);
+        }
+    }
+    printf("  ]\n");
+    printf("}\n");
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Wow & flutter demodulation benchmark, samples per second of :
+ *  - the IQ mixer alone, cos()/sin() per sample vs the Nco phasor recurrence
+ *  - the whole chain (band-pass, mixer, IQ low-pass, decimated phase difference)
+ *    as the former per-analysis thread ran it vs WowFlutterStream fed block by block
+ */
+#define _USE_MATH_DEFINES
+#include <nco.h>
+#include <utils.h>
+#include <Dsp.h>
+#include "wow_flutter_stream.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static const int SAMPLERATE = 48000;
+static const int REFERENCE = 3150;
+static const int DECIMATION = 20;
+static const int SAMPLES = SAMPLERATE * 11 / 2;
+static const int BLOCK = 4800;
+static const int ITERATIONS = 20;
+
+template<class F>
+static double samples_per_second(F fn)
+{
+    fn();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) fn();
+    auto stop = std::chrono::steady_clock::now();
+    return double(SAMPLES) * ITERATIONS / std::chrono::duration<double>(stop - start).count();
+}
+
+static void mix_sincos(const double* in, double* out_i, double* out_q, int size)
+{
+    const double step = 2. * M_PI * REFERENCE / SAMPLERATE;
+    for (int i = 0; i < size; ++i)
+    {
+        out_i[i] = in[i] * cos(step * double(i));
+        out_q[i] = in[i] * sin(step * double(i));
+    }
+}
+
+// Former WowAndFluterThread::entry() processing of the whole analysis window
+static double legacy_chain(const std::vector<double>& audio, std::vector<double>& signal_i, std::vector<double>& signal_q,
+                           std::vector<double>& deviation)
+{
+    Dsp::SimpleFilter <Dsp::ChebyshevI::BandPass <4>, 1> prefilter;
+    Dsp::SimpleFilter <Dsp::ChebyshevI::LowPass <4>, 2> iq_lowpass;
+    prefilter.setup(4, SAMPLERATE, REFERENCE, 500, 0.2);
+    iq_lowpass.setup(4, SAMPLERATE, 700, 0.1);
+
+    std::vector<double> filtered = audio;
+    double* prefilter_chans[1] = {filtered.data()};
+    prefilter.process(SAMPLES, prefilter_chans);
+    mix_sincos(filtered.data(), signal_i.data(), signal_q.data(), SAMPLES);
+    double* lp_chans[2] = {signal_i.data(), signal_q.data()};
+    iq_lowpass.process(SAMPLES, lp_chans);
+
+    const double phase_to_hz = SAMPLERATE / (M_PI * 2.);
+    for (int i = 1; i < (int)deviation.size(); ++i)
+    {
+        int step_i = i * DECIMATION;
+        double phase0 = complex_argument(signal_q[step_i-1], signal_i[step_i-1]);
+        double phase1 = complex_argument(signal_q[step_i], signal_i[step_i]);
+        deviation[i] = wrap_phase(phase0 - phase1) * phase_to_hz;
+    }
+    return deviation.back();
+}
+
+int main(int, char**)
+{
+    std::vector<double> audio(SAMPLES), out_i(SAMPLES), out_q(SAMPLES);
+    double phase = 0;
+    for (int i = 0; i < SAMPLES; ++i)
+    {
+        phase += 2. * M_PI * (REFERENCE + 3. * sin(2. * M_PI * 4. * i / SAMPLERATE)) / SAMPLERATE;
+        audio[i] = 0.5 * sin(phase);
+    }
+
+    double mixer_sincos = samples_per_second([&](){
+        mix_sincos(audio.data(), out_i.data(), out_q.data(), SAMPLES);
+    });
+
+    Nco nco;
+    nco.set_frequency(REFERENCE, SAMPLERATE);
+    nco.reset();
+    double mixer_nco = samples_per_second([&](){
+        nco.mix(audio.data(), out_i.data(), out_q.data(), SAMPLES);
+    });
+
+    std::vector<double> deviation(SAMPLES / DECIMATION);
+    double chain_legacy = samples_per_second([&](){
+        legacy_chain(audio, out_i, out_q, deviation);
+    });
+
+    WowFlutterStream stream;
+    stream.init(SAMPLERATE, DECIMATION, SAMPLES / DECIMATION);
+    stream.configure(REFERENCE, 0);
+    double chain_stream = samples_per_second([&](){
+        for (int i = 0; i < SAMPLES; i += BLOCK) stream.process(audio.data() + i, std::min(BLOCK, SAMPLES - i));
+    });
+
+    printf("%-24s %-16s %-16s %-8s\n", "stage", "before Msmp/s", "after Msmp/s", "speedup");
+    printf("%-24s %-16.1f %-16.1f %-8.2f\n", "IQ mixer", mixer_sincos * 1e-6, mixer_nco * 1e-6, mixer_nco / mixer_sincos);
+    printf("%-24s %-16.1f %-16.1f %-8.2f\n", "demodulation chain", chain_legacy * 1e-6, chain_stream * 1e-6, chain_stream / chain_legacy);
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "capture_writer.h"
+#include <cstring>
+#include <algorithm>
+
+void log_message(const char* format, ...);
+
+CaptureWriter::~CaptureWriter()
+{
+    stop_capture();
+}
+
+bool CaptureWriter::start_capture(const std::string& path, int samplerate, int channels, bool floatingpoint)
+{
+    stop_capture();
+
+    if (samplerate <= 0 || channels <= 0 || !m_wav.open(path, samplerate, channels, floatingpoint)) return false;
+
+    m_samplerate = samplerate;
+    m_channels = channels;
+    m_frames_written = 0;
+    m_dropped_frames = 0;
+    m_write_error = false;
+
+    const size_t queue_size = size_t(samplerate * CAPTURE_QUEUE_TIME) * channels;
+    m_queue = floatingpoint ? (SpscRingBuffer*)new spscRingBuffer<float>(queue_size) : (SpscRingBuffer*)new spscRingBuffer<int16_t>(queue_size);
+    m_block = new char[CAPTURE_WRITE_BLOCK_SIZE];
+    m_block_fill = 0;
+
+    start();
+    log_message("Capturing to %s", path.c_str());
+    return true;
+}
+
+void CaptureWriter::stop_capture()
+{
+    if (m_queue == nullptr) return;
+
+    stop();
+    join();
+    // The producer is gone, write what is left
+    drain(true);
+    if (!m_wav.close()) m_write_error = true;
+    if (m_write_error) log_message("Capture file write error, the capture is incomplete");
+    if (m_dropped_frames) log_message("Capture dropped %llu frames, the disk is too slow", (unsigned long long)m_dropped_frames);
+
+    delete m_queue;
+    m_queue = nullptr;
+    delete[] m_block;
+    m_block = nullptr;
+}
+
+bool CaptureWriter::push(const void* data1, size_t size1, const void* data2, size_t size2)
+{
+    if (m_queue == nullptr) return false;
+
+    if (m_queue->getWriteAvailable() < size1 + size2)
+    {
+        m_dropped_frames.fetch_add((size1 + size2) / m_channels, std::memory_order_relaxed);
+        return false;
+    }
+    m_queue->write(data1, size1);
+    if (size2) m_queue->write(data2, size2);
+    return true;
+}
+
+bool CaptureWriter::drain(bool flush)
+{
+    const size_t element_size = m_queue->getElementSize();
+    SpscRingBuffer::Regions regions;
+    const size_t available = m_queue->peek_read(m_queue->getBufferSize(), regions);
+
+    const char* parts[2] = {(const char*)regions.data1, (const char*)regions.data2};
+    const size_t sizes[2] = {regions.size1 * element_size, regions.size2 * element_size};
+    for (int i = 0; i < 2; ++i)
+    {
+        size_t done = 0;
+        while (done < sizes[i])
+        {
+            const size_t chunk = std::min(sizes[i] - done, size_t(CAPTURE_WRITE_BLOCK_SIZE) - m_block_fill);
+            memcpy(m_block + m_block_fill, parts[i] + done, chunk);
+            m_block_fill += chunk;
+            done += chunk;
+            if (m_block_fill == size_t(CAPTURE_WRITE_BLOCK_SIZE))
+            {
+                if (!m_wav.write(m_block, m_block_fill)) m_write_error = true;
+                m_block_fill = 0;
+            }
+        }
+    }
+    m_queue->commit_read(available);
+
+    if (flush && m_block_fill)
+    {
+        if (!m_wav.write(m_block, m_block_fill)) m_write_error = true;
+        m_block_fill = 0;
+    }
+    m_frames_written = m_wav.frames_written();
+    return available > 0;
+}
+
+void CaptureWriter::entry()
+{
+    // Nothing queued, the analysis pushes a block every hop
+    if (!drain(false)) usleep(10000);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread.h>
+#include <ringbuffer.h>
+#include <wav_file.h>
+
+// Size of each file write, a multiple of WAV_DATA_ALIGNMENT
+const int CAPTURE_WRITE_BLOCK_SIZE = 1 << 20;
+// Audio the queue can hold while the disk is busy
+const double CAPTURE_QUEUE_TIME = 4.0;
+
+/*
+ * Capture to disk, the analysis thread pushes the raw recorder blocks in a lock-free queue
+ * and never waits, this thread drains it to the WAV file in CAPTURE_WRITE_BLOCK_SIZE writes.
+ * If the disk can't keep up, the blocks that don't fit in the queue are dropped and counted
+ */
+class CaptureWriter : public Thread
+{
+    WavWriter           m_wav;
+    SpscRingBuffer*     m_queue = nullptr;
+    char*               m_block = nullptr;
+    size_t              m_block_fill = 0;
+    std::atomic<uint64_t> m_frames_written{0};
+    std::atomic<uint64_t> m_dropped_frames{0};
+    std::atomic<bool>   m_write_error{false};
+    int                 m_channels = 0;
+    int                 m_samplerate = 0;
+
+    // Moves what is queued to the write block, writes it when full or when flushing
+    bool drain(bool flush);
+
+public:
+    CaptureWriter() : Thread("CaptureWriter", true, false){}
+    ~CaptureWriter();
+
+    /*
+     * Opens the file and starts the writer thread
+     * The samples are pushed in the recorder format, float or 16 bits PCM
+     */
+    bool start_capture(const std::string& path, int samplerate, int channels, bool floatingpoint);
+    // Writes what is left in the queue and closes the file
+    void stop_capture();
+    bool capturing() const {return m_queue != nullptr;}
+
+    /*
+     * Producer side (analysis thread), interleaved samples as peeked from the recorder ring
+     * The whole block is queued or dropped
+     */
+    bool push(const void* data1, size_t size1, const void* data2, size_t size2);
+
+    double   captured_time() const {return m_samplerate ? double(m_frames_written) / m_samplerate : 0;}
+    uint64_t dropped_frames() const {return m_dropped_frames;}
+    bool     write_error() const {return m_write_error;}
+
+    void entry() override;
+};
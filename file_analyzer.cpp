@@ -0,0 +1,247 @@
+#include "file_analyzer.h"
+#include "audio_analyzer.h"
+#include <fftw3.h>
+#include <thread.h>
+#include <utils.h>
+#include <dsp_kernels.h>
+#include <harmonic_analysis.h>
+#include <spectrum_integrator.h>
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+// Frames demodulated at once, keeps the W&F work buffers small
+static const int FILE_WF_CHUNK_SIZE = 16384;
+
+/*
+ * One analysis thread, takes the next block of the file until there is none left
+ * Every buffer is its own, only the FFT plan and the window are shared (read only)
+ */
+class FileAnalysisWorker : public Thread
+{
+    FileAnalyzer&                   m_analyzer;
+    const FileAnalysisSettings&     m_settings;
+    std::vector<FileBlockResult>&   m_results;
+    const std::vector<double>&      m_window;
+    fftw_plan           m_plan;
+    int                 m_block_frames;
+    int                 m_preroll_frames;
+    double              m_energy_correction;
+
+    double*             m_fft_in = nullptr;
+    fftw_complex*       m_fft_out = nullptr;
+    std::vector<double> m_audio, m_other, m_power;
+    std::vector<double> m_wf_audio;
+    SpectrumIntegrator  m_spectrum;
+    HarmonicAnalysis    m_harmonics;
+
+    WowFlutterStream    m_wf_stream;
+    std::vector<double> m_deviation, m_signal_i, m_signal_q;
+
+    void analyze_block(int block);
+    void analyze_wow_flutter(uint64_t start, FileBlockResult& result);
+
+public:
+    FileAnalysisWorker(FileAnalyzer& analyzer, const FileAnalysisSettings& settings, std::vector<FileBlockResult>& results,
+                       const std::vector<double>& window, fftw_plan plan, double energy_correction);
+    ~FileAnalysisWorker();
+
+    void entry() override;
+};
+
+FileAnalysisWorker::FileAnalysisWorker(FileAnalyzer& analyzer, const FileAnalysisSettings& settings, std::vector<FileBlockResult>& results,
+                                       const std::vector<double>& window, fftw_plan plan, double energy_correction)
+    : Thread("FileAnalysisWorker", false, false), m_analyzer(analyzer), m_settings(settings), m_results(results),
+      m_window(window), m_plan(plan), m_energy_correction(energy_correction)
+{
+    const int samplerate = m_analyzer.m_file.samplerate();
+    m_block_frames = m_window.size();
+    m_preroll_frames = samplerate * FILE_WF_PREROLL_TIME;
+
+    m_audio.resize(m_block_frames);
+    m_other.resize(m_block_frames);
+    if (m_settings.compute_thd)
+    {
+        const int bins = m_block_frames / 2;
+        m_fft_in = fftw_alloc_real(m_block_frames);
+        m_fft_out = fftw_alloc_complex(bins + 1);
+        m_power.resize(bins);
+        m_spectrum.init(bins, double(samplerate) / m_block_frames);
+    }
+    if (m_settings.wow_reference_frequency > 0)
+    {
+        const int history_size = (m_preroll_frames + m_block_frames) / WOW_FLUTTER_DECIMATION;
+        m_wf_stream.init(samplerate, WOW_FLUTTER_DECIMATION, history_size);
+        m_wf_stream.configure(m_settings.wow_reference_frequency, m_settings.wf_filter_freq);
+        m_wf_audio.resize(FILE_WF_CHUNK_SIZE);
+        m_deviation.resize(history_size);
+        m_signal_i.resize(history_size);
+        m_signal_q.resize(history_size);
+    }
+}
+
+FileAnalysisWorker::~FileAnalysisWorker()
+{
+    fftw_free(m_fft_in);
+    fftw_free(m_fft_out);
+}
+
+void FileAnalysisWorker::entry()
+{
+    while (!m_analyzer.m_cancel)
+    {
+        const int block = m_analyzer.m_next_block++;
+        if (block >= m_analyzer.m_block_count) break;
+        analyze_block(block);
+        m_analyzer.m_blocks_done++;
+    }
+}
+
+void FileAnalysisWorker::analyze_block(int block)
+{
+    const MappedWavFile& file = m_analyzer.m_file;
+    const int samplerate = file.samplerate();
+    const int channel = m_settings.right_channel && file.channels() > 1 ? 1 : 0;
+    const uint64_t start = uint64_t(block) * m_block_frames;
+    FileBlockResult& result = m_results[block];
+    result.time = double(start) / samplerate;
+
+    // Level of both channels, the analysed one stays in m_audio
+    auto read_level = [&](int read_channel, std::vector<double>& audio) {
+        file.read_channel(read_channel, start, m_block_frames, audio.data());
+        double sumsq = 0;
+        for (double sample : audio) sumsq += sample * sample;
+        result.rms_db[read_channel] = std::max(linear_to_db(sqrt(sumsq / m_block_frames)), -300.);
+    };
+    if (file.channels() > 1) read_level(1 - channel, m_other);
+    read_level(channel, m_audio);
+
+    if (m_settings.compute_thd)
+    {
+        const int bins = m_block_frames / 2;
+        apply_window(m_audio.data(), m_window.data(), m_fft_in, m_block_frames);
+        fftw_execute_dft_r2c(m_plan, m_fft_in, m_fft_out);
+        for (int i = 0; i < bins; ++i)
+        {
+            m_power[i] = m_fft_out[i][0] * m_fft_out[i][0] + m_fft_out[i][1] * m_fft_out[i][1];
+        }
+
+        m_harmonics.compute_thd(m_power.data(), bins, double(samplerate) / m_block_frames, m_analyzer.m_peak_interpolator);
+        m_harmonics.compute_thdn(m_power.data(), bins, m_energy_correction, m_spectrum);
+        result.fundamental = m_harmonics.harmonics_freq[0];
+        result.thd = m_harmonics.thd;
+        result.thdn = m_harmonics.thdn;
+        result.thdn_audio_band = m_harmonics.thdn_audio_band;
+        result.thdn_a_weighted = m_harmonics.thdn_a_weighted;
+    }
+
+    if (m_settings.wow_reference_frequency > 0)
+    {
+        analyze_wow_flutter(start, result);
+    }
+}
+
+void FileAnalysisWorker::analyze_wow_flutter(uint64_t start, FileBlockResult& result)
+{
+    const MappedWavFile& file = m_analyzer.m_file;
+    const int channel = m_settings.right_channel && file.channels() > 1 ? 1 : 0;
+
+    // The demodulator starts before the block, except for the first one which skips its own beginning
+    const uint64_t preroll = std::min<uint64_t>(start, m_preroll_frames);
+    const uint64_t first = start - preroll;
+    const int total = preroll + m_block_frames;
+
+    m_wf_stream.reset();
+    for (int done = 0; done < total; done += FILE_WF_CHUNK_SIZE)
+    {
+        const int chunk = std::min(total - done, FILE_WF_CHUNK_SIZE);
+        file.read_channel(channel, first + done, chunk, m_wf_audio.data());
+        m_wf_stream.process(m_wf_audio.data(), chunk);
+    }
+    m_wf_stream.get_history(m_deviation.data(), m_signal_i.data(), m_signal_q.data());
+
+    // Oldest first, the measured part is at the end of the history
+    const int history_size = m_deviation.size();
+    const int measured = std::min((total - m_preroll_frames) / WOW_FLUTTER_DECIMATION, history_size);
+    if (measured <= 0) return;
+
+    double max_dev = -1000, min_dev = 1000, mean = 0;
+    for (int i = history_size - measured; i < history_size; ++i)
+    {
+        max_dev = std::max(max_dev, m_deviation[i]);
+        min_dev = std::min(min_dev, m_deviation[i]);
+        mean += m_deviation[i];
+    }
+    mean /= measured;
+
+    const double reference = m_settings.wow_reference_frequency;
+    result.wow_flutter = std::max(max_dev - mean, mean - min_dev) / (reference + mean) * 100.;
+    result.drift = mean / reference * 100.;
+}
+
+FileAnalyzer::FileAnalyzer()
+{
+    m_peak_interpolator.init(hann_fft_window);
+}
+
+bool FileAnalyzer::open(const std::string& path)
+{
+    return m_file.open(path);
+}
+
+bool FileAnalyzer::analyze(const FileAnalysisSettings& settings, std::vector<FileBlockResult>& results)
+{
+    results.clear();
+    if (!m_file.is_open()) return false;
+
+    // Even sized blocks, the whole file if shorter than one block
+    const uint64_t frames = m_file.frames();
+    const int block_frames = std::min<uint64_t>(std::max(lround(settings.block_time * m_file.samplerate()), 2L), frames) & ~1;
+    if (block_frames < 2) return false;
+
+    m_block_count = frames / block_frames;
+    m_next_block = 0;
+    m_blocks_done = 0;
+    m_cancel = false;
+    results.resize(m_block_count);
+
+    std::vector<double> window(block_frames);
+    double window_power = 0;
+    for (int i = 0; i < block_frames; ++i)
+    {
+        window[i] = hann_fft_window(i, block_frames);
+        window_power += window[i] * window[i];
+    }
+    const double energy_correction = block_frames / window_power;
+
+    // Planned here, the planner isn't thread safe, the workers only execute it on their own buffers
+    fftw_plan plan = NULL;
+    if (settings.compute_thd)
+    {
+        ScopedMutex planner_lock(AudioAnalyzer::fftw_planner_mutex());
+        double* in = fftw_alloc_real(block_frames);
+        fftw_complex* out = fftw_alloc_complex(block_frames / 2 + 1);
+        plan = fftw_plan_dft_r2c_1d(block_frames, in, out, FFTW_ESTIMATE);
+        fftw_free(in);
+        fftw_free(out);
+    }
+
+    int threads = settings.threads > 0 ? settings.threads : (int)std::thread::hardware_concurrency();
+    threads = std::max(std::min(threads, m_block_count), 1);
+
+    std::vector<std::unique_ptr<FileAnalysisWorker>> workers;
+    for (int i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(new FileAnalysisWorker(*this, settings, results, window, plan, energy_correction));
+        workers.back()->start();
+    }
+    for (auto& worker : workers) worker->join();
+    workers.clear();
+
+    if (plan)
+    {
+        ScopedMutex planner_lock(AudioAnalyzer::fftw_planner_mutex());
+        fftw_destroy_plan(plan);
+    }
+    return !m_cancel;
+}
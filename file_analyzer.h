@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <wav_file.h>
+#include <peak_interpolator.h>
+
+// Demodulated before each block so the W&F filters are settled, same margin as the realtime analysis
+const double FILE_WF_PREROLL_TIME = 0.5;
+
+struct FileAnalysisSettings
+{
+    double  block_time = 5.0;               // Seconds of audio behind each result
+    bool    right_channel = false;
+    bool    compute_thd = true;
+    int     wow_reference_frequency = 0;    // W&F carrier, no W&F analysis if 0
+    int     wf_filter_freq = 0;             // Low-pass of the W&F deviation, Hz, none if 0
+    int     threads = 0;                    // One per core if 0
+};
+
+/*
+ * Measures of one block of the file
+ */
+struct FileBlockResult
+{
+    double  time = 0;                       // Block start, seconds
+    double  rms_db[2] = {-300, -300};       // dBFS, left and right
+    double  fundamental = 0;                // Hz
+    double  thd = 0;                        // %
+    double  thdn = 0;                       // %
+    double  thdn_audio_band = 0;            // %
+    double  thdn_a_weighted = 0;            // %
+    double  wow_flutter = 0;                // Peak deviation, % of the carrier
+    double  drift = 0;                      // Carrier offset, % of the reference
+};
+
+/*
+ * Offline analysis of a WAV file, faster than realtime
+ * The file is memory mapped and cut in blocks, worker threads take the next block until
+ * the end of the file. Each block goes through the realtime analysis building blocks :
+ * Hann window and FFT for the level and the THD/THD+N (HarmonicAnalysis), and its own
+ * WowFlutterStream started FILE_WF_PREROLL_TIME before the block
+ */
+class FileAnalyzer
+{
+    MappedWavFile       m_file;
+    PeakInterpolator    m_peak_interpolator;
+    std::atomic<int>    m_next_block{0};
+    std::atomic<int>    m_blocks_done{0};
+    std::atomic<bool>   m_cancel{false};
+    int                 m_block_count = 0;
+
+    friend class FileAnalysisWorker;
+
+public:
+    FileAnalyzer();
+
+    bool open(const std::string& path);
+    void close(){m_file.close();}
+    const MappedWavFile& file() const {return m_file;}
+
+    // Blocking, returns false if the file isn't open or if cancelled
+    bool analyze(const FileAnalysisSettings& settings, std::vector<FileBlockResult>& results);
+
+    // Can be called from any thread while analyze() runs
+    float progress() const {return m_block_count ? float(m_blocks_done) / m_block_count : 0.f;}
+    void  cancel(){m_cancel = true;}
+};
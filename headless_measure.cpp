@@ -0,0 +1,555 @@
+#include "headless_measure.h"
+#include "audio_analyzer.h"
+#include "file_analyzer.h"
+#include <audio_manager.h>
+#include <audio_recorder.h>
+#include <audio_source.h>
+#include <audio_generator.h>
+#include <utils.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Blocks analysed before this time are dropped, they hold the stimulus and stream startup
+static const double HEADLESS_SETTLE_TIME = 0.5;
+// Floor of the dB readings, keeps the JSON output finite on silence
+static const double HEADLESS_MIN_DB = -300.;
+
+static double to_db(double linear)
+{
+    return std::max(linear_to_db(linear), HEADLESS_MIN_DB);
+}
+
+// Quotes and backslashes of Windows paths escaped
+static std::string json_string(const std::string& s)
+{
+    std::string out;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static void print_usage(const char* program)
+{
+    fprintf(stderr,
+        "Usage: %s --measure thd|wow [options]\n"
+        "       %s --list-devices\n"
+        "  --device N       input device index (default input device)\n"
+        "  --output N       play the test tone on output device N (no stimulus by default)\n"
+        "  --rate HZ        input samplerate (device default)\n"
+        "  --seconds S      measurement time (10)\n"
+        "  --frequency HZ   test tone and wow & flutter reference frequency (1000)\n"
+        "  --level DB       test tone level, dB full scale (-6)\n"
+        "  --latency MS     recorder latency, also sets the FFT size (100)\n"
+        "  --right          analyse the right channel\n"
+        "  --record FILE    record the input to a WAV file\n"
+        "  --file FILE      analyse a WAV file instead of the input, in blocks of --seconds (5)\n"
+        "  --replay FILE    feed a WAV file (e.g. a --record capture) to the realtime analysis, as fast as possible\n"
+        "  --synthetic      analyse a generated test tone instead of the input, as fast as possible\n"
+        "  --harmonics DB,DB,...  synthetic H2, H3... levels relative to the fundamental\n"
+        "  --noise DB       synthetic white noise RMS level, dB full scale (none)\n"
+        "  --wow PERCENT    synthetic peak frequency deviation (none)\n"
+        "  --wow-rate HZ    synthetic frequency modulation rate (4)\n"
+        "  --json           print the result as JSON\n",
+        program, program);
+}
+
+static bool parse_int(const char* arg, int& value)
+{
+    char* end = nullptr;
+    long v = strtol(arg, &end, 10);
+    if (end == arg || *end != 0) return false;
+    value = (int)v;
+    return true;
+}
+
+static bool parse_double(const char* arg, double& value)
+{
+    char* end = nullptr;
+    double v = strtod(arg, &end);
+    if (end == arg || *end != 0) return false;
+    value = v;
+    return true;
+}
+
+static bool parse_double_list(const char* arg, std::vector<double>& values)
+{
+    values.clear();
+    std::string list = arg;
+    size_t pos = 0;
+    for (;;)
+    {
+        const size_t comma = list.find(',', pos);
+        double value;
+        if (!parse_double(list.substr(pos, comma - pos).c_str(), value)) return false;
+        values.push_back(value);
+        if (comma == std::string::npos) return true;
+        pos = comma + 1;
+    }
+}
+
+bool parse_headless_options(int argc, char* argv[], HeadlessOptions& options)
+{
+    bool headless = false;
+    bool valid = true;
+    bool help = false;
+    for (int i = 1; i < argc && valid && !help; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool takes_value = true;
+
+        if (strcmp(arg, "--measure") == 0)
+        {
+            headless = true;
+            valid = value && (strcmp(value, "thd") == 0 || strcmp(value, "wow") == 0);
+            if (valid) options.measure = value;
+        }
+        else if (strcmp(arg, "--list-devices") == 0)
+        {
+            headless = true;
+            options.list_devices = true;
+            takes_value = false;
+        }
+        else if (strcmp(arg, "--device") == 0) valid = value && parse_int(value, options.input_device);
+        else if (strcmp(arg, "--output") == 0) valid = value && parse_int(value, options.output_device);
+        else if (strcmp(arg, "--rate") == 0) valid = value && parse_int(value, options.samplerate) && options.samplerate > 0;
+        else if (strcmp(arg, "--seconds") == 0)
+        {
+            valid = value && parse_double(value, options.seconds) && options.seconds > 0;
+            options.seconds_set = true;
+        }
+        else if (strcmp(arg, "--frequency") == 0) valid = value && parse_double(value, options.frequency) && options.frequency > 0;
+        else if (strcmp(arg, "--level") == 0) valid = value && parse_int(value, options.level_db) && options.level_db <= 0;
+        else if (strcmp(arg, "--latency") == 0) valid = value && parse_int(value, options.latency_ms) && options.latency_ms > 0;
+        else if (strcmp(arg, "--record") == 0)
+        {
+            valid = value != nullptr;
+            if (valid) options.record_path = value;
+        }
+        else if (strcmp(arg, "--file") == 0)
+        {
+            valid = value != nullptr;
+            if (valid) options.file_path = value;
+        }
+        else if (strcmp(arg, "--replay") == 0)
+        {
+            valid = value != nullptr;
+            if (valid) options.replay_path = value;
+        }
+        else if (strcmp(arg, "--synthetic") == 0)
+        {
+            options.synthetic = true;
+            takes_value = false;
+        }
+        else if (strcmp(arg, "--harmonics") == 0) valid = value && parse_double_list(value, options.harmonics_db);
+        else if (strcmp(arg, "--noise") == 0) valid = value && parse_double(value, options.noise_db);
+        else if (strcmp(arg, "--wow") == 0) valid = value && parse_double(value, options.wow_depth) && options.wow_depth >= 0;
+        else if (strcmp(arg, "--wow-rate") == 0) valid = value && parse_double(value, options.wow_rate) && options.wow_rate > 0;
+        else if (strcmp(arg, "--right") == 0)
+        {
+            options.right_channel = true;
+            takes_value = false;
+        }
+        else if (strcmp(arg, "--json") == 0)
+        {
+            options.json = true;
+            takes_value = false;
+        }
+        else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+        {
+            headless = help = true;
+            takes_value = false;
+        }
+        else
+        {
+            // Unknown arguments are left to the UI (e.g. -psn_ on macOS) unless headless
+            takes_value = false;
+            if (headless) valid = false;
+        }
+
+        if (valid && takes_value) i++;
+        if (!valid) fprintf(stderr, "Invalid argument: %s%s%s\n", arg, value && takes_value ? " " : "", value && takes_value ? value : "");
+    }
+
+    if (headless && (!valid || help || (options.measure.empty() && !options.list_devices)))
+    {
+        print_usage(argv[0]);
+        options.measure.clear();
+        options.list_devices = false;
+    }
+    return headless;
+}
+
+static void list_devices(PAaudioManager& manager)
+{
+    const std::vector<std::string>& inputs = manager.get_input_devices();
+    const std::vector<std::string>& outputs = manager.get_output_devices();
+    printf("Input devices (default %i):\n", manager.get_default_input_device_id());
+    for (size_t i = 0; i < inputs.size(); ++i) printf("  %2i  %s\n", (int)i, inputs[i].c_str());
+    printf("Output devices (default %i):\n", manager.get_default_output_device_id());
+    for (size_t i = 0; i < outputs.size(); ++i) printf("  %2i  %s\n", (int)i, outputs[i].c_str());
+}
+
+// Device samplerate, the requested one if supported, the device default if not requested
+static int select_samplerate(const std::vector<int>& samplerates, int default_idx, int requested)
+{
+    if (samplerates.empty()) return 0;
+    if (requested <= 0) return samplerates[default_idx >= 0 && default_idx < (int)samplerates.size() ? default_idx : 0];
+    return std::find(samplerates.begin(), samplerates.end(), requested) != samplerates.end() ? requested : 0;
+}
+
+/*
+ * Distortion readings are averaged in power over the analysed blocks
+ */
+struct HeadlessAccumulator
+{
+    int     blocks = 0;
+    double  fundamental = 0;
+    double  rms_power = 0;
+    double  thd_power = 0;
+    double  thdn_power = 0;
+    double  thdn_audio_band_power = 0;
+    double  thdn_a_weighted_power = 0;
+    unsigned long max_compute_time = 0;
+
+    void add(const AnalysisResults& results, bool right)
+    {
+        const double rms = right ? results.rms_right : results.rms_left;
+        blocks++;
+        fundamental += results.fft_harmonics_freq[0];
+        rms_power += rms * rms;
+        thd_power += results.thd * results.thd;
+        thdn_power += results.thdn * results.thdn;
+        thdn_audio_band_power += results.thdn_audio_band * results.thdn_audio_band;
+        thdn_a_weighted_power += results.thdn_a_weighted * results.thdn_a_weighted;
+        max_compute_time = std::max(max_compute_time, results.compute_time);
+    }
+};
+
+/*
+ * Offline analysis, the whole file is measured block by block on every core
+ */
+static int run_file_analysis(const HeadlessOptions& options)
+{
+    FileAnalyzer analyzer;
+    if (!analyzer.open(options.file_path))
+    {
+        fprintf(stderr, "Cannot open %s\n", options.file_path.c_str());
+        return 1;
+    }
+
+    const bool wow = options.measure == "wow";
+    FileAnalysisSettings settings;
+    settings.block_time = options.seconds_set ? options.seconds : 5.0;
+    settings.right_channel = options.right_channel;
+    settings.compute_thd = !wow;
+    settings.wow_reference_frequency = wow ? (int)lround(options.frequency) : 0;
+
+    std::vector<FileBlockResult> blocks;
+    const auto start = std::chrono::steady_clock::now();
+    analyzer.analyze(settings, blocks);
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const MappedWavFile& file = analyzer.file();
+
+    // Worst block over the file
+    FileBlockResult worst;
+    for (const FileBlockResult& block : blocks)
+    {
+        worst.thd = std::max(worst.thd, block.thd);
+        worst.thdn = std::max(worst.thdn, block.thdn);
+        worst.wow_flutter = std::max(worst.wow_flutter, block.wow_flutter);
+    }
+
+    if (options.json)
+    {
+        printf("{\n");
+        printf("  \"measure\": \"%s\",\n", options.measure.c_str());
+        printf("  \"file\": \"%s\",\n", json_string(options.file_path).c_str());
+        printf("  \"samplerate\": %i,\n", file.samplerate());
+        printf("  \"channels\": %i,\n", file.channels());
+        printf("  \"duration\": %.3f,\n", file.duration());
+        printf("  \"analysis_time\": %.3f,\n", elapsed);
+        printf("  \"block_time\": %.3f,\n", settings.block_time);
+        if (wow) printf("  \"max_wow_flutter_percent\": %.5f,\n", worst.wow_flutter);
+        else printf("  \"max_thd_percent\": %.6f,\n  \"max_thdn_percent\": %.6f,\n", worst.thd, worst.thdn);
+        printf("  \"blocks\": [");
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            const FileBlockResult& b = blocks[i];
+            printf("%s\n    {\"time\": %.3f, \"rms_dbfs\": [%.3f, %.3f], ", i ? "," : "", b.time, b.rms_db[0], b.rms_db[1]);
+            if (wow) printf("\"wow_flutter_percent\": %.5f, \"frequency_drift_percent\": %.5f}", b.wow_flutter, b.drift);
+            else printf("\"fundamental_hz\": %.3f, \"thd_percent\": %.6f, \"thdn_percent\": %.6f, \"thdn_audio_band_percent\": %.6f, \"thdn_a_weighted_percent\": %.6f}",
+                        b.fundamental, b.thd, b.thdn, b.thdn_audio_band, b.thdn_a_weighted);
+        }
+        printf("\n  ]\n}\n");
+    }
+    else
+    {
+        printf("%s : %iHz, %i channels, %.1fs analysed in %.2fs\n", options.file_path.c_str(), file.samplerate(),
+               file.channels(), file.duration(), elapsed);
+        for (const FileBlockResult& b : blocks)
+        {
+            printf("%9.1fs  L %7.2f dBFS  R %7.2f dBFS  ", b.time, b.rms_db[0], b.rms_db[1]);
+            if (wow) printf("W&F %.4f %%  drift %+.4f %%\n", b.wow_flutter, b.drift);
+            else printf("%9.2f Hz  THD %.5f %%  THD+N %.5f %%\n", b.fundamental, b.thd, b.thdn);
+        }
+        if (wow) printf("Max W&F %.4f %%\n", worst.wow_flutter);
+        else printf("Max THD %.5f %%, max THD+N %.5f %%\n", worst.thd, worst.thdn);
+    }
+    return blocks.empty() ? 2 : 0;
+}
+
+/*
+ * Analyses the source for options.seconds and prints the averaged measurement
+ * input_idx is the device index of a sound card input, -1 for a rendered source named source_name
+ */
+static int measure_source(const HeadlessOptions& options, AudioSource& source, int capture_size, int input_idx,
+                          const StreamStats* stream_stats, RenderedAudioSource* rendered, const std::string& source_name = "")
+{
+    const int samplerate = source.get_current_samplerate();
+    AudioAnalyzer analyzer(source);
+    analyzer.init_capture(capture_size, samplerate, false);
+
+    AnalysisSettings settings;
+    settings.compute_on = true;
+    settings.fft_channel_left = !options.right_channel;
+    settings.show_thd = options.measure == "thd";
+    settings.show_wow_flutter = options.measure == "wow";
+    settings.wow_reference_frequency = (int)lround(options.frequency);
+    analyzer.set_settings(settings);
+    if (!options.record_path.empty() && !analyzer.start_recording(options.record_path))
+    {
+        fprintf(stderr, "Cannot record to %s\n", options.record_path.c_str());
+        return 1;
+    }
+
+    // The analysis runs in this thread, there is nothing else to do while measuring
+    HeadlessAccumulator accumulator;
+    // A rendered source is measured in audio time, as fast as the analysis runs
+    const auto start = std::chrono::steady_clock::now();
+    source.pause(false);
+    for (;;)
+    {
+        const double elapsed = rendered ? double(rendered->frames_read()) / samplerate :
+                               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= options.seconds || (rendered && rendered->finished())) break;
+
+        if (!analyzer.process())
+        {
+            if (!rendered) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (analyzer.fetch_new_results())
+        {
+            if (elapsed >= HEADLESS_SETTLE_TIME) accumulator.add(analyzer.get_results(), options.right_channel);
+        }
+    }
+    source.pause(true);
+    analyzer.stop_recording();
+    const double analysis_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const StreamStats::Snapshot stats = stream_stats ? stream_stats->snapshot() : StreamStats::Snapshot();
+    const unsigned long long xruns = stats.input_overflows + stats.input_underflows;
+    const int blocks = std::max(accumulator.blocks, 1);
+    const double rms = sqrt(accumulator.rms_power / blocks);
+    const double thd = sqrt(accumulator.thd_power / blocks);
+    const double thdn = sqrt(accumulator.thdn_power / blocks);
+    const double thdn_audio_band = sqrt(accumulator.thdn_audio_band_power / blocks);
+    const double thdn_a_weighted = sqrt(accumulator.thdn_a_weighted_power / blocks);
+    const double fundamental = accumulator.fundamental / blocks;
+
+    // The last published frame, the analysis is stopped
+    analyzer.fetch_new_results();
+    const WowFlutterFrame& wow_frame = analyzer.get_wow_flutter();
+    const bool wow_ready = options.measure == "wow" && !wow_frame.buffering;
+    double wow_peak = 0, wow_drift = 0;
+    if (wow_ready)
+    {
+        wow_peak = wow_frame.peak / (options.frequency + wow_frame.mean) * 100.;
+        wow_drift = wow_frame.mean / options.frequency * 100.;
+    }
+
+    if (accumulator.blocks == 0 || (options.measure == "wow" && !wow_ready))
+    {
+        fprintf(stderr, "Not enough audio data, measure for a longer time\n");
+    }
+
+    if (options.json)
+    {
+        printf("{\n");
+        printf("  \"measure\": \"%s\",\n", options.measure.c_str());
+        if (input_idx >= 0) printf("  \"input_device\": %i,\n", input_idx);
+        else printf("  \"source\": \"%s\",\n  \"analysis_time\": %.3f,\n", json_string(source_name).c_str(), analysis_time);
+        printf("  \"samplerate\": %i,\n", samplerate);
+        printf("  \"fft_size\": %i,\n", analyzer.capture_size());
+        printf("  \"channel\": \"%s\",\n", options.right_channel ? "right" : "left");
+        printf("  \"blocks\": %i,\n", accumulator.blocks);
+        printf("  \"rms_dbfs\": %.3f,\n", to_db(rms));
+        if (options.measure == "thd")
+        {
+            printf("  \"fundamental_hz\": %.3f,\n", fundamental);
+            printf("  \"thd_percent\": %.6f,\n", thd);
+            printf("  \"thd_db\": %.3f,\n", to_db(thd / 100.));
+            printf("  \"thdn_percent\": %.6f,\n", thdn);
+            printf("  \"thdn_audio_band_percent\": %.6f,\n", thdn_audio_band);
+            printf("  \"thdn_a_weighted_percent\": %.6f,\n", thdn_a_weighted);
+        }
+        else
+        {
+            printf("  \"reference_hz\": %.3f,\n", options.frequency);
+            printf("  \"wow_flutter_valid\": %s,\n", wow_ready ? "true" : "false");
+            printf("  \"wow_flutter_peak_percent\": %.5f,\n", wow_peak);
+            printf("  \"frequency_drift_percent\": %.5f,\n", wow_drift);
+        }
+        printf("  \"max_compute_time_us\": %lu,\n", accumulator.max_compute_time);
+        printf("  \"xruns\": %llu,\n", xruns);
+        printf("  \"dropped_frames\": %llu\n", (unsigned long long)stats.dropped_frames);
+        printf("}\n");
+    }
+    else
+    {
+        if (input_idx >= 0) printf("Input device %i, ", input_idx);
+        else printf("%s, %.1fs analysed in %.2fs, ", source_name.c_str(), double(rendered->frames_read()) / samplerate, analysis_time);
+        printf("%iHz, FFT size %i, %s channel, %i blocks\n", samplerate,
+               analyzer.capture_size(), options.right_channel ? "right" : "left", accumulator.blocks);
+        printf("RMS             : %.2f dBFS\n", to_db(rms));
+        if (options.measure == "thd")
+        {
+            printf("Fundamental     : %.2f Hz\n", fundamental);
+            printf("THD             : %.5f %% (%.2f dB)\n", thd, to_db(thd / 100.));
+            printf("THD+N           : %.5f %%\n", thdn);
+            printf("THD+N 20-20kHz  : %.5f %%\n", thdn_audio_band);
+            printf("THD+N A-weighted: %.5f %%\n", thdn_a_weighted);
+        }
+        else if (wow_ready)
+        {
+            printf("W&F peak        : %.4f %%\n", wow_peak);
+            printf("Frequency drift : %.4f %%\n", wow_drift);
+        }
+        printf("Xruns %llu, dropped frames %llu\n", xruns, (unsigned long long)stats.dropped_frames);
+    }
+
+    analyzer.destroy_capture();
+    return accumulator.blocks > 0 && (options.measure != "wow" || wow_ready) ? 0 : 2;
+}
+
+/*
+ * The analysis fed with the test signal instead of a device, no audio hardware needed
+ * The signal is known, its readings check the analysis accuracy
+ */
+static int run_synthetic_measurement(const HeadlessOptions& options)
+{
+    SyntheticSignal signal;
+    signal.samplerate = options.samplerate > 0 ? options.samplerate : 48000;
+    signal.frequency = options.frequency;
+    signal.level_db = options.level_db;
+    signal.harmonics_db = options.harmonics_db;
+    signal.noise_db = options.noise_db;
+    signal.wow_frequency = options.wow_rate;
+    signal.wow_depth = options.wow_depth;
+
+    SyntheticAudioSource source(signal);
+    const int capture_size = signal.samplerate * options.latency_ms / 1000;
+    return measure_source(options, source, capture_size, -1, nullptr, &source, "synthetic");
+}
+
+/*
+ * The realtime analysis fed with a WAV file, a --record capture is measured again without the hardware
+ * The whole file is analysed unless --seconds is given
+ */
+static int run_replay_measurement(const HeadlessOptions& options)
+{
+    WavFileAudioSource source;
+    if (!source.open(options.replay_path))
+    {
+        fprintf(stderr, "Cannot open %s\n", options.replay_path.c_str());
+        return 1;
+    }
+
+    HeadlessOptions replay_options = options;
+    if (!options.seconds_set) replay_options.seconds = source.file().duration();
+    const int capture_size = source.get_current_samplerate() * options.latency_ms / 1000;
+    return measure_source(replay_options, source, capture_size, -1, nullptr, &source, options.replay_path);
+}
+
+int run_headless_measurement(const HeadlessOptions& options)
+{
+    if (options.measure.empty() && !options.list_devices) return 1;
+    if (!options.file_path.empty() && !options.list_devices) return run_file_analysis(options);
+    if (!options.replay_path.empty() && !options.list_devices) return run_replay_measurement(options);
+    if (options.synthetic && !options.list_devices) return run_synthetic_measurement(options);
+
+    PAaudioManager manager;
+    if (!manager.valid())
+    {
+        fprintf(stderr, "PortAudio initialization failed\n");
+        return 1;
+    }
+
+    if (options.list_devices)
+    {
+        list_devices(manager);
+        return 0;
+    }
+
+    const int input_idx = options.input_device >= 0 ? options.input_device : manager.get_default_input_device_id();
+    if (input_idx < 0 || input_idx >= (int)manager.get_input_devices().size())
+    {
+        fprintf(stderr, "Invalid input device %i, see --list-devices\n", input_idx);
+        return 1;
+    }
+    const int samplerate = select_samplerate(manager.get_input_sample_rates(input_idx),
+                                             manager.get_default_input_samplerate_idx(input_idx), options.samplerate);
+    if (samplerate == 0)
+    {
+        fprintf(stderr, "Samplerate %i not supported by input device %i\n", options.samplerate, input_idx);
+        return 1;
+    }
+
+    const float latency = options.latency_ms / 1000.f;
+    PAaudioRecorder recorder(manager);
+    PAaudioWaveformGenerator generator(manager);
+    if (!recorder.init(latency, input_idx, samplerate))
+    {
+        fprintf(stderr, "Cannot open input device %i at %iHz\n", input_idx, samplerate);
+        return 1;
+    }
+
+    if (options.output_device >= 0)
+    {
+        if (options.output_device >= (int)manager.get_output_devices().size())
+        {
+            fprintf(stderr, "Invalid output device %i, see --list-devices\n", options.output_device);
+            return 1;
+        }
+        // Same samplerate as the input if possible, the stimulus doesn't need to be in sync
+        const std::vector<int> output_samplerates = manager.get_output_sample_rates(options.output_device);
+        int output_samplerate = select_samplerate(output_samplerates, 0, samplerate);
+        if (output_samplerate == 0) output_samplerate = select_samplerate(output_samplerates,
+                                        manager.get_default_output_samplerate_idx(options.output_device), 0);
+        if (!generator.init(options.output_device, output_samplerate, 0.01f))
+        {
+            fprintf(stderr, "Cannot open output device %i\n", options.output_device);
+            return 1;
+        }
+        generator.set_pitch(options.frequency, 0);
+        generator.set_volume(options.level_db);
+        generator.start();
+    }
+
+    const int exit_code = measure_source(options, recorder, recorder.get_buffer_size(latency, false), input_idx, &recorder.get_stats(), nullptr);
+    if (options.output_device >= 0)
+    {
+        generator.pause();
+        generator.destroy();
+    }
+    return exit_code;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*
+ * Command line options of the headless measurement mode
+ * The mode is selected with --measure, no window nor GL context is created
+ */
+struct HeadlessOptions
+{
+    std::string measure;            // "thd" or "wow"
+    int     input_device = -1;      // Index in the input device list, default device if < 0
+    int     output_device = -1;     // Generator output, no stimulus if < 0
+    int     samplerate = 0;         // Input device default if 0
+    double  seconds = 10;
+    bool    seconds_set = false;
+    double  frequency = 1000;       // Stimulus frequency, also the W&F reference
+    int     level_db = -6;          // Stimulus level, dB full scale
+    int     latency_ms = 100;       // Recorder latency, sets the FFT size like in the UI
+    bool    right_channel = false;
+    std::string record_path;        // Input recorded to this WAV file if set
+    std::string file_path;          // WAV file analysed instead of the input device if set
+    std::string replay_path;        // WAV file fed to the realtime analysis instead of the input device if set
+    bool    synthetic = false;      // Generated test tone analysed instead of the input device
+    std::vector<double> harmonics_db;   // Synthetic H2, H3... relative to the fundamental
+    double  noise_db = -300;        // Synthetic white noise RMS, dB full scale
+    double  wow_depth = 0;          // Synthetic peak frequency deviation, %
+    double  wow_rate = 4;           // Synthetic frequency modulation rate, Hz
+    bool    json = false;
+    bool    list_devices = false;
+};
+
+/*
+ * Parses argv, returns false if the headless mode isn't requested
+ * On a malformed command line, the usage is printed and options.measure is left empty
+ */
+bool parse_headless_options(int argc, char* argv[], HeadlessOptions& options);
+
+/*
+ * Runs the recorder, the generator and the analysis for the requested time
+ * (or analyses a WAV file or a synthetic signal, see --file, --replay and --synthetic)
+ * and prints the measurement on stdout, returns the process exit code
+ */
+int run_headless_measurement(const HeadlessOptions& options);
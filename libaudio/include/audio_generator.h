@@ -1,6 +1,12 @@
 #include <audio_manager.h>
 #include "noise.h"
-#include "sine_generator.h"
+#include "wavetable_oscillator.h"
+#include "multitone.h"
+#include "log_sweep.h"
+#include "stream_stats.h"
+
+// Frames rendered at once by the audio callback
+const int GENERATOR_BLOCK_SIZE = 256;
 
 class PAaudioWaveformGenerator{
 public:
@@ -10,7 +16,9 @@ public:
         TRIANGLE,
         WHITE_NOISE,
         BROWN_NOISE,
-        PINK_NOISE
+        PINK_NOISE,
+        MULTITONE,
+        LOG_SWEEP
     };
     WhiteNoiseGenerator m_whitenoise;
     BrownNoiseGenerator m_brownnoise;
@@ -25,15 +33,21 @@ private:
     int m_mode = SINE;
     PaStream *m_outstream = nullptr;
     StreamInfo m_outstreaminfo;
-    SineWave m_sinewave;
+    WavetableOscillator m_oscillator;
+    float m_block[GENERATOR_BLOCK_SIZE];
+    MultitoneTable m_multitone;
+    LogSweep m_log_sweep;
     PAaudioManager& m_manager;
     bool m_is_playing = false;
+    StreamStats m_stats;
 
     static int generator_callback(const void* input, void* output,
                     unsigned long frameCount,
                     const PaStreamCallbackTimeInfo* timeInfo,
                     PaStreamCallbackFlags statusFlags,
                     void* userData);
+    // One block of the current waveform, volume applied
+    void render(float* out, int frames);
 
 public:
     PAaudioWaveformGenerator(PAaudioManager& manager);
@@ -47,11 +61,21 @@ public:
     bool pause(bool pause = true);
 
     int  get_samplerate();
+    StreamStats& get_stats(){return m_stats;}
 
     void set_pitch(double pitch, double duration = 0.1);
     void set_hw_volume(float vol);
     void set_volume(int db, double duration = 0.1);
 
+    /*
+     * Builds the multitone table, period should be the analysis FFT size
+     * Rebuilding it while the multitone is playing needs the generator paused
+     */
+    void set_multitone(int period, int tones, double min_freq, double max_freq);
+    const MultitoneTable& multitone() const {return m_multitone;}
+    // Renders the sweep, it is played once from the start when the LOG_SWEEP mode is selected
+    void set_log_sweep(double start_freq, double end_freq, double duration);
+
     void set_mode(int m);
     int& mode(){return m_mode;};
     bool mode_tunable(){
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "audio_manager.h"
+#include "stream_stats.h"
 #include <inttypes.h>
 
 class PAaudioLoopback
@@ -8,8 +9,9 @@ class PAaudioLoopback
     PAaudioManager& m_manager;
     PaStream *m_outstream = nullptr;
     StreamInfo m_outstreaminfo;
-    IringBuffer* m_ringbuffer = nullptr;
+    SpscRingBuffer* m_ringbuffer = nullptr;
     bool m_playing = false;
+    StreamStats m_stats;
 
     static int generator_callback(const void* input, void* output,
                     unsigned long frameCount,
@@ -28,5 +30,8 @@ public:
     void destroy();
     bool set(int samplerate, float latency, int device_idx, int channels);
     bool add_data(const float data[], int size);
+    // Data already in the stream sample format, written in one go or not at all
+    bool add_raw_data(const void* data1, size_t size1, const void* data2, size_t size2);
     void pause(bool pause = true);
+    StreamStats& get_stats(){return m_stats;}
 };
\ No newline at end of file
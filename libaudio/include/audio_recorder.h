@@ -1,13 +1,16 @@
 #pragma once
 
 #include "audio_manager.h"
+#include "stream_stats.h"
+#include "audio_source.h"
 
-class PAaudioRecorder
+class PAaudioRecorder : public AudioSource
 {
-    IringBuffer *m_ring_buffer = nullptr;
+    SpscRingBuffer *m_ring_buffer = nullptr;
     PaStream* m_instream = nullptr;
     PAaudioManager& m_manager;
     StreamInfo m_instreaminfo;
+    StreamStats m_stats;
 
     static int recordCallback(
     const void *inputBuffer,
@@ -23,16 +26,21 @@ public:
     void destroy();
 
     bool init(float latency, int device_idx, int samplerate);
-    int get_available_samples();
+    int get_available_samples() override;
     bool start();
-    bool pause(bool);
+    bool pause(bool) override;
 
-    bool get_data(std::vector<float>& data, size_t size);
-    int  get_current_samplerate();
-    int  get_channel_count();
+    // Zero-copy read, exposes the ring regions holding 'size' samples in the stream format
+    // The regions stay valid until consume_data() is called (consumer thread only)
+    bool peek_data(size_t size, SpscRingBuffer::Regions& regions) override;
+    void consume_data(size_t size) override;
+    bool is_floatingpoint() override {return m_instreaminfo.format == paFloat32;}
+    int  get_current_samplerate() override;
+    int  get_channel_count() override;
 
     int get_buffer_size(float time, bool channels_mult = true);
     float get_ringbuffer_occupation();
+    StreamStats& get_stats(){return m_stats;}
 
     void set_input_gain_db(float gain);
     void set_input_gain_linear(float gain);
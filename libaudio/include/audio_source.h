@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include "ringbuffer.h"
+#include "noise.h"
+#include "wav_file.h"
+
+/*
+ * Interleaved audio consumed by the analysis, a sound card input or a generated stream
+ * The data is read in place : peek_data() exposes 'size' samples in the source format
+ * (float or int16_t), they stay valid until consume_data() (consumer thread only)
+ */
+class AudioSource
+{
+public:
+    virtual ~AudioSource(){}
+
+    virtual int  get_available_samples() = 0;
+    virtual bool peek_data(size_t size, SpscRingBuffer::Regions& regions) = 0;
+    virtual void consume_data(size_t size) = 0;
+    virtual bool is_floatingpoint() = 0;
+    virtual int  get_current_samplerate() = 0;
+    virtual int  get_channel_count() = 0;
+    virtual bool pause(bool) = 0;
+};
+
+/*
+ * Source rendering its float samples on demand, as fast as the consumer reads them
+ * There is no stream behind it : peek_data() renders the missing frames at the end of a
+ * linear buffer, the consumed ones are moved out when the buffer is full
+ */
+class RenderedAudioSource : public AudioSource
+{
+    std::vector<float>  m_buffer;
+    size_t              m_read_pos = 0;
+    size_t              m_write_pos = 0;
+    uint64_t            m_frames_read = 0;
+    bool                m_end = false;
+
+protected:
+    int m_samplerate = 0;
+    int m_channels = 0;
+
+    // Fills 'frames' interleaved frames, returns less at the end of the data
+    virtual int render(float* out, int frames) = 0;
+    void restart();
+
+public:
+    int  get_available_samples() override;
+    bool peek_data(size_t size, SpscRingBuffer::Regions& regions) override;
+    void consume_data(size_t size) override;
+    bool is_floatingpoint() override {return true;}
+    int  get_current_samplerate() override {return m_samplerate;}
+    int  get_channel_count() override {return m_channels;}
+    bool pause(bool) override {return true;}
+
+    // Audio time read by the consumer
+    uint64_t frames_read() const {return m_frames_read;}
+    bool     finished() const {return m_end && m_read_pos == m_write_pos;}
+};
+
+/*
+ * Test signal, a sine with its harmonics, white noise and a sinusoidal frequency modulation (wow)
+ * The same signal is rendered on every channel, the noise is independent
+ * The stream is deterministic, the same settings always render the same samples
+ */
+struct SyntheticSignal
+{
+    int     samplerate = 48000;
+    int     channels = 2;
+    double  frequency = 1000;
+    double  level_db = -6;                  // Fundamental peak level, dB full scale
+    std::vector<double> harmonics_db;       // H2, H3... levels relative to the fundamental
+    double  noise_db = -300;                // White noise RMS level, dB full scale
+    double  wow_frequency = 0;              // Modulation rate, Hz
+    double  wow_depth = 0;                  // Peak frequency deviation, % of the frequency
+    double  duration = 0;                   // Seconds, endless if 0
+};
+
+class SyntheticAudioSource : public RenderedAudioSource
+{
+    SyntheticSignal     m_signal;
+    std::vector<double> m_harmonic_gains;
+    std::vector<float>  m_noise;
+    WhiteNoiseGenerator m_noise_generator;
+    double  m_gain = 0;
+    double  m_noise_gain = 0;
+    double  m_phase = 0;                    // Cycles, wrapped to [0, 1)
+    double  m_wow_phase = 0;
+    uint64_t m_frames_rendered = 0;
+
+protected:
+    int render(float* out, int frames) override;
+
+public:
+    SyntheticAudioSource(const SyntheticSignal& signal){init(signal);}
+
+    void init(const SyntheticSignal& signal);
+    const SyntheticSignal& signal() const {return m_signal;}
+};
+
+/*
+ * WAV or RF64 file read through MappedWavFile, the first two channels converted to float
+ */
+class WavFileAudioSource : public RenderedAudioSource
+{
+    MappedWavFile       m_file;
+    std::vector<double> m_channel_data;
+    uint64_t            m_position = 0;
+    bool                m_loop = false;
+
+protected:
+    int render(float* out, int frames) override;
+
+public:
+    // Rewinds at the end of the file if loop is set
+    bool open(const std::string& path, bool loop = false);
+    void close(){m_file.close();}
+    const MappedWavFile& file() const {return m_file;}
+};
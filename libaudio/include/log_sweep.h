@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+/*
+ * Exponential sine sweep (Farina), frequency grows by the same ratio every second
+ * so each harmonic of the sweep is the sweep itself shifted in time by rate() * ln(order),
+ * which is what lets the deconvolution separate them.
+ * The sweep is rendered once and played from the table, silence follows the end
+ */
+class LogSweep
+{
+    std::vector<float> m_table;
+    int     m_position = 0;
+    double  m_start_freq = 20;
+    double  m_end_freq = 20000;
+    double  m_duration = 0;
+
+public:
+    LogSweep(){}
+
+    /*
+     * Renders a sweep from start_freq to end_freq, short fades at both ends avoid the clicks
+     * The same call is used by the analysis to get the reference stimulus at its samplerate
+     */
+    static void render(double start_freq, double end_freq, double duration, int samplerate, std::vector<double>& out);
+    // Time constant L of the sweep, the frequency is start_freq * exp(t / L)
+    static double rate(double start_freq, double end_freq, double duration);
+
+    void init(double start_freq, double end_freq, double duration, int samplerate);
+
+    float sample()
+    {
+        if (m_position >= (int)m_table.size()) return 0.f;
+        return m_table[m_position++];
+    }
+
+    void reset(){m_position = 0;}
+    bool done() const {return m_position >= (int)m_table.size();}
+
+    double start_frequency() const {return m_start_freq;}
+    double end_frequency() const {return m_end_freq;}
+    double duration() const {return m_duration;}
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+/*
+ * Periodic multitone stimulus
+ * Equal amplitude tones on exact bins of a period matching the analysis FFT size,
+ * so every tone falls on an FFT bin whatever the window and the capture alignment.
+ * The phases are optimised for a low crest factor and the whole period is precomputed,
+ * the audio callback only reads the table
+ */
+class MultitoneTable
+{
+    std::vector<float>  m_table;
+    std::vector<int>    m_bins;
+    int     m_position = 0;
+    int     m_samplerate = 0;
+    double  m_tone_amplitude = 0;
+    double  m_crest_factor = 0;
+
+public:
+    MultitoneTable(){}
+
+    /*
+     * Log spaced bins of the period between min_freq and max_freq, at least min_spacing bins apart
+     * so the window main lobes don't overlap, fewer than tones are returned at low resolution
+     */
+    static std::vector<int> log_spaced_bins(int period, int samplerate, int tones, double min_freq, double max_freq, int min_spacing = 4);
+
+    // Builds the table, the peak is normalized to 1
+    void init(const std::vector<int>& bins, int period, int samplerate, int iterations = 60);
+
+    float sample()
+    {
+        if (m_table.empty()) return 0.f;
+        float s = m_table[m_position];
+        if (++m_position == (int)m_table.size()) m_position = 0;
+        return s;
+    }
+
+    void reset(){m_position = 0;}
+
+    int     period() const {return m_table.size();}
+    double  tone_amplitude() const {return m_tone_amplitude;}
+    double  crest_factor() const {return m_crest_factor;}
+    std::vector<double> frequencies() const;
+};
@@ -1,52 +1,65 @@
 #pragma once
 
 #include <stdint.h>
-#include <math.h>
-
+#include <stddef.h>
+#include <algorithm>
 
+/*
+ * Noise generators rendering whole blocks
+ * White noise comes from a counter-based generator : sample n is a hash of (n, seed),
+ * there is no serial dependency between samples so the block loop vectorizes
+ * (32 bit multiplies, integer to float conversion) and any position can be jumped to.
+ * Output is in [-1, 1)
+ */
 class NoiseGeneratorBase {
-    uint64_t u,v,w;
-    bool is_seed_init = false;
-    
-public:
-    NoiseGeneratorBase(){
-        is_seed_init = false;
+    uint64_t m_counter = 0;
+    uint32_t m_seed;
+    uint32_t m_key;
+
+    // 32 bit integer hash (lowbias32, C. Wellons), full avalanche, bijective
+    static uint32_t hash32(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        return x;
     }
+
+    void update_key(){m_key = hash32(uint32_t(m_counter >> 32) ^ hash32(m_seed));}
+
+public:
+    NoiseGeneratorBase(uint32_t seed = 0x9e3779b9U) : m_seed(seed){update_key();}
     virtual ~NoiseGeneratorBase(){}
 
-    virtual double sample() = 0;
+    virtual void render(float* out, size_t n) = 0;
 
-    uint64_t randq64_uint64()
-    {    
-        if (!is_seed_init){
-            is_seed_init = true;
-            v = 4101842887655102017LL;
-            w = 1;
-            u = 1ULL ^ v; 
-            randq64_uint64();
-            v = u; 
-            randq64_uint64();
-            w = v; 
-            randq64_uint64();
-        }
-        
-        u = u * 2862933555777941757LL + 7046029254386353087LL;
-        v ^= v >> 17; 
-        v ^= v << 31; 
-        v ^= v >> 8;
-        w = 4294957665U*(w & 0xffffffff) + (w >> 32);
-        uint64_t x = u ^ (u << 21); 
-        x ^= x >> 35; 
-        x ^= x << 4;
-        return (x + v) ^ w;
+    void seek(uint64_t position)
+    {
+        m_counter = position;
+        update_key();
     }
 
-    double randq64_double()
+    void render_white(float* out, size_t n)
     {
-        return 5.42101086242752217E-20 * randq64_uint64();
+        const float scale = 1.f / 2147483648.f;
+        while (n)
+        {
+            // The high half of the counter goes in the key, the low half must not wrap inside the loop
+            const uint32_t low = uint32_t(m_counter);
+            const size_t count = (size_t)std::min<uint64_t>(n, (uint64_t(1) << 32) - low);
+            const uint32_t key = m_key;
+            for (size_t i = 0; i < count; ++i)
+            {
+                out[i] = float(int32_t(hash32((low + uint32_t(i)) ^ key))) * scale;
+            }
+            m_counter += count;
+            if (uint32_t(m_counter) == 0) update_key();
+            out += count;
+            n -= count;
+        }
     }
-
-
 };
 
 class WhiteNoiseGenerator : public NoiseGeneratorBase {
@@ -54,42 +67,53 @@ public:
     WhiteNoiseGenerator() : NoiseGeneratorBase() {
     }
 
-    double sample() override {
-        return 2.0 * randq64_double() - 1.0;
+    void render(float* out, size_t n) override {
+        render_white(out, n);
     }
 };
 
-class BrownNoiseGenerator : public WhiteNoiseGenerator {
-    double lastOutput;
+class BrownNoiseGenerator : public NoiseGeneratorBase {
+    double lastOutput = 0.0;
 public:
-    BrownNoiseGenerator() : WhiteNoiseGenerator() {
-        lastOutput = 0.0;
+    BrownNoiseGenerator() : NoiseGeneratorBase() {
     }
 
-    double sample() override {
-        double white = WhiteNoiseGenerator::sample();
-        lastOutput = lastOutput - (0.025 * (lastOutput - white));
-        return lastOutput; 
+    void render(float* out, size_t n) override {
+        render_white(out, n);
+        double last = lastOutput;
+        for (size_t i = 0; i < n; ++i)
+        {
+            last = last - (0.025 * (last - out[i]));
+            out[i] = last;
+        }
+        lastOutput = last;
     }
 };
 
-class PinkNoiseGenerator : public WhiteNoiseGenerator {
-    double b0, b1, b2, b3, b4, b5, b6;  
+/*
+ * Paul Kellet's pink filter (within 0.05dB of -3dB/octave above 9Hz at 44.1kHz)
+ * applied to a white block
+ */
+class PinkNoiseGenerator : public NoiseGeneratorBase {
+    double b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0;
 public:
-    PinkNoiseGenerator() : WhiteNoiseGenerator() {
-        b0 = b1 = b2 = b3 = b4 = b5 = b6 = 0.0;
+    PinkNoiseGenerator() : NoiseGeneratorBase() {
     }
-    
-    double sample() override {
-        double white = WhiteNoiseGenerator::sample();
-        b0 = 0.99886 * b0 + white * 0.0555179;
-        b1 = 0.99332 * b1 + white * 0.0750759;
-        b2 = 0.96900 * b2 + white * 0.1538520;
-        b3 = 0.86650 * b3 + white * 0.3104856;
-        b4 = 0.55000 * b4 + white * 0.5329522;
-        b5 = -0.7616 * b5 - white * 0.0168980;
-        double pink = b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362;
-        b6 = white * 0.115926;
-        return pink * 0.11; // Gain compensation
+
+    void render(float* out, size_t n) override {
+        render_white(out, n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            const double white = out[i];
+            b0 = 0.99886 * b0 + white * 0.0555179;
+            b1 = 0.99332 * b1 + white * 0.0750759;
+            b2 = 0.96900 * b2 + white * 0.1538520;
+            b3 = 0.86650 * b3 + white * 0.3104856;
+            b4 = 0.55000 * b4 + white * 0.5329522;
+            b5 = -0.7616 * b5 - white * 0.0168980;
+            const double pink = b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362;
+            b6 = white * 0.115926;
+            out[i] = pink * 0.11; // Gain compensation
+        }
     }
-};
\ No newline at end of file
+};
@@ -6,6 +6,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <atomic>
 
 #define FullMemoryBarrier()  __sync_synchronize()
 #define ReadMemoryBarrier()  __sync_synchronize()
@@ -196,3 +197,188 @@ public:
     ringBuffer(size_t size) : IringBuffer(sizeof(T), size){};
     virtual ~ringBuffer(){};
 };
+
+/*
+ * Single producer / single consumer lock-free ring buffer
+ * Indices are free running and only masked on access, the write index is owned by the producer,
+ * the read index by the consumer, each one sits on its own cache line with a cached copy
+ * of the other side's index so the shared lines are only touched when the cache runs out.
+ * Data is accessed in place with peek_write/commit_write and peek_read/commit_read
+ * (at most two regions when the access wraps around the end of the buffer).
+ * flush() is not thread safe, call it while the stream is stopped.
+ */
+class SpscRingBuffer
+{
+public:
+    struct Regions
+    {
+        void    *data1 = nullptr;
+        size_t  size1 = 0;
+        void    *data2 = nullptr;
+        size_t  size2 = 0;
+    };
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    size_t  m_buffer_size; /**< Number of elements in FIFO. Power of 2. **/
+    size_t  m_mask;
+    size_t  m_element_size_bytes;
+    char    *m_buffer;
+
+    // Producer side
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_write_index;
+    size_t  m_cached_read_index;
+
+    // Consumer side
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_read_index;
+    size_t  m_cached_write_index;
+
+    void get_regions(size_t index, size_t elementCount, Regions& regions)
+    {
+        index &= m_mask;
+        regions.data1 = &m_buffer[index*m_element_size_bytes];
+        if ((index + elementCount) > m_buffer_size)
+        {
+            regions.size1 = m_buffer_size - index;
+            regions.data2 = &m_buffer[0];
+            regions.size2 = elementCount - regions.size1;
+        }
+        else
+        {
+            regions.size1 = elementCount;
+            regions.data2 = nullptr;
+            regions.size2 = 0;
+        }
+    }
+
+public:
+    SpscRingBuffer(size_t elementSizeBytes, size_t elementCount)
+    {
+        elementCount = nextPowerOfTwoFP(elementCount);
+        m_buffer_size = elementCount;
+        m_mask = elementCount - 1;
+        m_element_size_bytes = elementSizeBytes;
+        m_buffer = (char *)malloc(elementSizeBytes * elementCount);
+        flush();
+    }
+
+    virtual ~SpscRingBuffer()
+    {
+        free(m_buffer);
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t getBufferSize() const
+    {
+        return m_buffer_size;
+    }
+
+    size_t getElementSize() const
+    {
+        return m_element_size_bytes;
+    }
+
+    void flush()
+    {
+        m_write_index.store(0, std::memory_order_relaxed);
+        m_read_index.store(0, std::memory_order_relaxed);
+        m_cached_read_index = 0;
+        m_cached_write_index = 0;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    // Can be called from any thread, the result is only a snapshot
+    size_t getReadAvailable() const
+    {
+        size_t read_index = m_read_index.load(std::memory_order_acquire);
+        return m_write_index.load(std::memory_order_acquire) - read_index;
+    }
+
+    size_t getWriteAvailable() const
+    {
+        return m_buffer_size - getReadAvailable();
+    }
+
+    /*
+     * Producer : get up to elementCount writable elements, returns the number of elements available
+     * in the regions. Nothing is visible to the consumer until commit_write()
+     */
+    size_t peek_write(size_t elementCount, Regions& regions)
+    {
+        size_t write_index = m_write_index.load(std::memory_order_relaxed);
+        size_t available = m_buffer_size - (write_index - m_cached_read_index);
+        if (available < elementCount)
+        {
+            m_cached_read_index = m_read_index.load(std::memory_order_acquire);
+            available = m_buffer_size - (write_index - m_cached_read_index);
+        }
+        if (elementCount > available) elementCount = available;
+        get_regions(write_index, elementCount, regions);
+        return elementCount;
+    }
+
+    void commit_write(size_t elementCount)
+    {
+        m_write_index.store(m_write_index.load(std::memory_order_relaxed) + elementCount, std::memory_order_release);
+    }
+
+    /*
+     * Consumer : get up to elementCount readable elements, returns the number of elements available
+     * in the regions. They stay valid until commit_read()
+     */
+    size_t peek_read(size_t elementCount, Regions& regions)
+    {
+        size_t read_index = m_read_index.load(std::memory_order_relaxed);
+        size_t available = m_cached_write_index - read_index;
+        if (available < elementCount)
+        {
+            m_cached_write_index = m_write_index.load(std::memory_order_acquire);
+            available = m_cached_write_index - read_index;
+        }
+        if (elementCount > available) elementCount = available;
+        get_regions(read_index, elementCount, regions);
+        return elementCount;
+    }
+
+    void commit_read(size_t elementCount)
+    {
+        m_read_index.store(m_read_index.load(std::memory_order_relaxed) + elementCount, std::memory_order_release);
+    }
+
+    size_t write(const void *data, size_t elementCount)
+    {
+        Regions regions;
+        size_t numWritten = peek_write(elementCount, regions);
+        memcpy(regions.data1, data, regions.size1*m_element_size_bytes);
+        if (regions.size2 > 0)
+        {
+            memcpy(regions.data2, (const char *)data + regions.size1*m_element_size_bytes, regions.size2*m_element_size_bytes);
+        }
+        commit_write(numWritten);
+        return numWritten;
+    }
+
+    size_t read(void *data, size_t elementCount)
+    {
+        Regions regions;
+        size_t numRead = peek_read(elementCount, regions);
+        memcpy(data, regions.data1, regions.size1*m_element_size_bytes);
+        if (regions.size2 > 0)
+        {
+            memcpy((char *)data + regions.size1*m_element_size_bytes, regions.data2, regions.size2*m_element_size_bytes);
+        }
+        commit_read(numRead);
+        return numRead;
+    }
+};
+
+template<class T>
+class spscRingBuffer : public SpscRingBuffer
+{
+public:
+    spscRingBuffer(size_t size) : SpscRingBuffer(sizeof(T), size){};
+    virtual ~spscRingBuffer(){};
+};
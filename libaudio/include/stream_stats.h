@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <portaudio.h>
+
+/*
+ * Per stream callback instrumentation
+ * The audio callback is the only writer, each counter is a relaxed atomic so the UI can read
+ * them at any time without locking or disturbing the callback. A reset is only requested
+ * by the reader and done by the callback itself
+ */
+class StreamStats
+{
+public:
+    // Callback duration histogram, upper bounds as a fraction of the callback deadline
+    static const int HISTOGRAM_BINS = 6;
+    static constexpr double HISTOGRAM_BOUNDS[HISTOGRAM_BINS - 1] = {0.1, 0.25, 0.5, 0.75, 1.0};
+
+    struct Snapshot
+    {
+        uint64_t callbacks = 0;
+        uint64_t frames = 0;
+        uint64_t dropped_frames = 0;
+        uint64_t input_overflows = 0;
+        uint64_t input_underflows = 0;
+        uint64_t output_overflows = 0;
+        uint64_t output_underflows = 0;
+        uint64_t histogram[HISTOGRAM_BINS] = {0};
+        uint32_t max_duration_us = 0;
+        // Highest ring buffer occupancy seen by the callback, per mille
+        uint32_t ring_high_water = 0;
+    };
+
+private:
+    std::atomic<uint64_t> m_callbacks{0};
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_dropped_frames{0};
+    std::atomic<uint64_t> m_input_overflows{0};
+    std::atomic<uint64_t> m_input_underflows{0};
+    std::atomic<uint64_t> m_output_overflows{0};
+    std::atomic<uint64_t> m_output_underflows{0};
+    std::atomic<uint64_t> m_histogram[HISTOGRAM_BINS] = {};
+    std::atomic<uint32_t> m_max_duration_us{0};
+    std::atomic<uint32_t> m_ring_high_water{0};
+    std::atomic<bool>     m_reset_requested{false};
+
+    // Single writer, no read-modify-write needed
+    template<class T>
+    static void add(std::atomic<T>& counter, T value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    template<class T>
+    static void raise(std::atomic<T>& value, T candidate)
+    {
+        if (candidate > value.load(std::memory_order_relaxed)) value.store(candidate, std::memory_order_relaxed);
+    }
+
+    void clear()
+    {
+        m_callbacks.store(0, std::memory_order_relaxed);
+        m_frames.store(0, std::memory_order_relaxed);
+        m_dropped_frames.store(0, std::memory_order_relaxed);
+        m_input_overflows.store(0, std::memory_order_relaxed);
+        m_input_underflows.store(0, std::memory_order_relaxed);
+        m_output_overflows.store(0, std::memory_order_relaxed);
+        m_output_underflows.store(0, std::memory_order_relaxed);
+        for (std::atomic<uint64_t>& bin : m_histogram) bin.store(0, std::memory_order_relaxed);
+        m_max_duration_us.store(0, std::memory_order_relaxed);
+        m_ring_high_water.store(0, std::memory_order_relaxed);
+    }
+
+public:
+    /*
+     * Callback side, instantiate at the beginning of the callback, the duration
+     * is accounted when it goes out of scope
+     */
+    class Scope
+    {
+        StreamStats& m_stats;
+        std::chrono::steady_clock::time_point m_start;
+        double m_deadline;
+
+    public:
+        Scope(StreamStats& stats, unsigned long frames, double samplerate, PaStreamCallbackFlags flags)
+            : m_stats(stats), m_start(std::chrono::steady_clock::now())
+        {
+            if (m_stats.m_reset_requested.exchange(false, std::memory_order_relaxed)) m_stats.clear();
+            m_deadline = samplerate > 0 ? frames / samplerate : 0;
+            add<uint64_t>(m_stats.m_callbacks, 1);
+            add<uint64_t>(m_stats.m_frames, frames);
+            if (flags & paInputOverflow) add<uint64_t>(m_stats.m_input_overflows, 1);
+            if (flags & paInputUnderflow) add<uint64_t>(m_stats.m_input_underflows, 1);
+            if (flags & paOutputOverflow) add<uint64_t>(m_stats.m_output_overflows, 1);
+            if (flags & paOutputUnderflow) add<uint64_t>(m_stats.m_output_underflows, 1);
+        }
+
+        ~Scope()
+        {
+            const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+            int bin = 0;
+            while (bin < HISTOGRAM_BINS - 1 && duration > HISTOGRAM_BOUNDS[bin] * m_deadline) bin++;
+            add<uint64_t>(m_stats.m_histogram[bin], 1);
+            raise<uint32_t>(m_stats.m_max_duration_us, uint32_t(duration * 1e6));
+        }
+
+        void dropped(unsigned long frames){add<uint64_t>(m_stats.m_dropped_frames, frames);}
+        void ring_occupancy(size_t used, size_t size)
+        {
+            if (size) raise<uint32_t>(m_stats.m_ring_high_water, uint32_t(used * 1000 / size));
+        }
+    };
+
+    // Reader side
+    Snapshot snapshot() const
+    {
+        Snapshot s;
+        s.callbacks = m_callbacks.load(std::memory_order_relaxed);
+        s.frames = m_frames.load(std::memory_order_relaxed);
+        s.dropped_frames = m_dropped_frames.load(std::memory_order_relaxed);
+        s.input_overflows = m_input_overflows.load(std::memory_order_relaxed);
+        s.input_underflows = m_input_underflows.load(std::memory_order_relaxed);
+        s.output_overflows = m_output_overflows.load(std::memory_order_relaxed);
+        s.output_underflows = m_output_underflows.load(std::memory_order_relaxed);
+        for (int i = 0; i < HISTOGRAM_BINS; ++i) s.histogram[i] = m_histogram[i].load(std::memory_order_relaxed);
+        s.max_duration_us = m_max_duration_us.load(std::memory_order_relaxed);
+        s.ring_high_water = m_ring_high_water.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // Applied by the next callback
+    void reset(){m_reset_requested.store(true, std::memory_order_relaxed);}
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <cstdio>
+#include <stdint.h>
+
+// The data chunk starts on this boundary, the header is padded with a JUNK chunk
+const int WAV_DATA_ALIGNMENT = 4096;
+
+/*
+ * Streaming WAV writer, 16 bits PCM or 32 bits float interleaved samples
+ * The sizes are patched in the header on close(), the file becomes RF64 if the data
+ * doesn't fit in the 32 bits RIFF sizes (about 1h40 of 192kHz stereo float)
+ * The header is padded so that the samples start on a WAV_DATA_ALIGNMENT file offset
+ */
+class WavWriter
+{
+    FILE*       m_file = nullptr;
+    int         m_samplerate = 0;
+    int         m_channels = 0;
+    bool        m_floatingpoint = true;
+    uint64_t    m_data_bytes = 0;
+
+    bool write_header(bool rf64);
+
+public:
+    WavWriter(){}
+    ~WavWriter(){close();}
+
+    bool open(const std::string& path, int samplerate, int channels, bool floatingpoint);
+    // Interleaved samples in the file format, sizes in bytes
+    bool write(const void* data, size_t size);
+    bool close();
+
+    bool     is_open() const {return m_file != nullptr;}
+    int      frame_size() const {return m_channels * (m_floatingpoint ? sizeof(float) : sizeof(int16_t));}
+    uint64_t frames_written() const {return m_channels ? m_data_bytes / frame_size() : 0;}
+};
+
+/*
+ * Read only memory mapped WAV or RF64 file, 16/24/32 bits PCM or 32 bits float
+ * The pages are loaded by the OS as they are read, any thread can read any part of the file
+ * A data chunk with a zero or oversized length (unfinished capture) extends to the end of the file
+ */
+class MappedWavFile
+{
+    const uint8_t*  m_map = nullptr;
+    uint64_t        m_map_size = 0;
+#ifdef WIN32
+    void*           m_file_handle = nullptr;
+    void*           m_mapping_handle = nullptr;
+#else
+    int             m_fd = -1;
+#endif
+    const uint8_t*  m_data = nullptr;
+    uint64_t        m_frames = 0;
+    int             m_samplerate = 0;
+    int             m_channels = 0;
+    int             m_bytes_per_sample = 0;
+    bool            m_floatingpoint = false;
+
+    bool map(const std::string& path);
+    bool parse();
+
+public:
+    MappedWavFile(){}
+    ~MappedWavFile(){close();}
+
+    bool open(const std::string& path);
+    void close();
+
+    bool     is_open() const {return m_data != nullptr;}
+    int      samplerate() const {return m_samplerate;}
+    int      channels() const {return m_channels;}
+    uint64_t frames() const {return m_frames;}
+    double   duration() const {return m_samplerate ? double(m_frames) / m_samplerate : 0;}
+
+    // count frames of one channel from first_frame, scaled to [-1, 1]
+    void read_channel(int channel, uint64_t first_frame, int count, double* out) const;
+};
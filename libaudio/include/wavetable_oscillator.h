@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+/*
+ * Band-limited wavetable oscillator
+ * Each waveform is stored as one table per octave (mip-map), a table only holds the harmonics
+ * staying below Nyquist up to the top of its octave, so square and triangle don't alias.
+ * The phase is normalized and wrapped every sample, rendering is done by blocks, unit amplitude
+ */
+class WavetableOscillator
+{
+public:
+    enum Waveform {
+        SINE,
+        SQUARE,
+        TRIANGLE,
+        WAVEFORM_COUNT
+    };
+
+    static const int TABLE_SIZE = 4096;
+    // Octave tables from LOWEST_OCTAVE_FREQ, the last one is used up to Nyquist
+    static const int OCTAVES = 11;
+
+private:
+    // OCTAVES tables of TABLE_SIZE + 1 samples per waveform, the extra sample is the first one
+    std::vector<float> m_tables[WAVEFORM_COUNT];
+    int     m_waveform = SINE;
+    double  m_samplerate = 0;
+    double  m_phase = 0;
+
+    double  m_frequency = 0;
+    double  m_frequency_step = 0;
+    int     m_frequency_steps = 0;
+    double  m_target_frequency = 0;
+
+    const float* octave_table(double frequency) const;
+
+public:
+    WavetableOscillator(){}
+
+    // Builds the tables, starts at 0Hz
+    void init(double samplerate);
+
+    void set_waveform(int waveform){m_waveform = waveform;}
+    // Linear transition over duration seconds
+    void set_frequency(double frequency, double duration = 0);
+    void reset(){m_phase = 0;}
+
+    void render(float* out, int frames);
+};
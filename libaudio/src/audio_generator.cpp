@@ -1,5 +1,6 @@
 #include <audio_generator.h>
 #include <utils.h>
+#include <algorithm>
 
 void log_message(const char* format, ...);
 
@@ -14,6 +15,7 @@ int PAaudioWaveformGenerator::generator_callback(const void* input, void* output
     PAaudioWaveformGenerator* udata = (PAaudioWaveformGenerator*)userData;
 
     const StreamInfo info = udata->get_info();
+    StreamStats::Scope stats(udata->m_stats, frameCount, info.sampleRate, statusFlags);
     bool is_floatingpoint = (info.format == paFloat32);
 
     if (!udata->m_is_playing)
@@ -22,41 +24,61 @@ int PAaudioWaveformGenerator::generator_callback(const void* input, void* output
         return paAbort;
     }
 
-    double float_sample_rate = info.sampleRate;
-    double seconds_per_frame = 1.0 / float_sample_rate;
-
     int16_t* dataint = (int16_t*)output;
     float* datafloat = (float*)output;
 
-    float volume = udata->m_volume;
-    for (int i = 0; i < frameCount; ++i){
-        double sample = 0;
-        if (udata->m_mode <= TRIANGLE)
-        {
-            sample = volume * udata->m_sinewave.sample();
-        }
-        else if (udata->m_mode == WHITE_NOISE)
-        {
-            sample = volume * udata->m_whitenoise.sample();
-        }
-        else if (udata->m_mode == BROWN_NOISE)
-        {
-            sample = volume * udata->m_brownnoise.sample();
-        } else if (udata->m_mode == PINK_NOISE)
-        {
-            sample = volume * udata->m_pinknoise.sample();
-        }
+    for (unsigned long done = 0; done < frameCount;)
+    {
+        const int frames = std::min(frameCount - done, (unsigned long)GENERATOR_BLOCK_SIZE);
+        udata->render(udata->m_block, frames);
 
-        for (int channel = 0; channel < info.numChannel; channel ++)
+        for (int i = 0; i < frames; ++i)
         {
-            if (is_floatingpoint) *datafloat++ = (float)sample;
-            else *dataint++ = (int16_t)(sample * INT16_MAX);
+            const float sample = udata->m_block[i];
+            for (int channel = 0; channel < info.numChannel; channel ++)
+            {
+                if (is_floatingpoint) *datafloat++ = sample;
+                else *dataint++ = (int16_t)(sample * INT16_MAX);
+            }
         }
+        done += frames;
     }
 
     return paContinue;
 }
 
+void PAaudioWaveformGenerator::render(float* out, int frames)
+{
+    switch (m_mode)
+    {
+    case SINE:
+    case SQUARE:
+    case TRIANGLE:
+        m_oscillator.render(out, frames);
+        break;
+    case WHITE_NOISE:
+        m_whitenoise.render(out, frames);
+        break;
+    case BROWN_NOISE:
+        m_brownnoise.render(out, frames);
+        break;
+    case PINK_NOISE:
+        m_pinknoise.render(out, frames);
+        break;
+    case MULTITONE:
+        for (int i = 0; i < frames; ++i) out[i] = m_multitone.sample();
+        break;
+    case LOG_SWEEP:
+        for (int i = 0; i < frames; ++i) out[i] = m_log_sweep.sample();
+        break;
+    default:
+        std::fill(out, out + frames, 0.f);
+    }
+
+    const float volume = m_volume;
+    for (int i = 0; i < frames; ++i) out[i] *= volume;
+}
+
 PAaudioWaveformGenerator::PAaudioWaveformGenerator(PAaudioManager& manager) : m_manager(manager)
 {
 
@@ -84,7 +106,7 @@ bool PAaudioWaveformGenerator::init(int device_idx, int samplerate, float latenc
     
     destroy();
     
-    m_sinewave.set(0, samplerate, 1.);
+    m_oscillator.init(samplerate);
     
     m_outstream = m_manager.get_output_stream(samplerate, device_idx, latency, generator_callback, this, m_outstreaminfo);
 
@@ -109,10 +131,22 @@ bool PAaudioWaveformGenerator::start()
     return pause(false);
 }
 
+void PAaudioWaveformGenerator::set_multitone(int period, int tones, double min_freq, double max_freq)
+{
+    const int samplerate = get_samplerate();
+    m_multitone.init(MultitoneTable::log_spaced_bins(period, samplerate, tones, min_freq, max_freq), period, samplerate);
+    log_message("Multitone : %i tones, crest factor %.2f\n", (int)m_multitone.frequencies().size(), m_multitone.crest_factor());
+}
+
+void PAaudioWaveformGenerator::set_log_sweep(double start_freq, double end_freq, double duration)
+{
+    m_log_sweep.init(start_freq, end_freq, duration, get_samplerate());
+}
+
 void PAaudioWaveformGenerator::set_mode(int m)
 {
     m_mode = m;
-    m_sinewave.set_function((SineWave::WaveformFunction)m);
+    if (m <= TRIANGLE) m_oscillator.set_waveform(m);
 }
 
 bool PAaudioWaveformGenerator::pause(bool pause)
@@ -137,13 +171,12 @@ bool PAaudioWaveformGenerator::pause(bool pause)
 void PAaudioWaveformGenerator::set_pitch(double pitch, double duration)
 {
     m_pitch = pitch;
-    m_sinewave.sine_wave_frequency_transition(m_pitch, duration);
+    m_oscillator.set_frequency(m_pitch, duration);
 }
 
 void PAaudioWaveformGenerator::set_volume(int db, double duration)
 {
-    m_volume = db_to_linear(db);   
-    m_sinewave.sine_wave_amplitude_transition(1.0, duration); 
+    m_volume = db_to_linear(db);
 }
 
 void PAaudioWaveformGenerator::set_hw_volume(float vol)
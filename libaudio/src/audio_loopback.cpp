@@ -10,18 +10,32 @@ int PAaudioLoopback::generator_callback(const void* input, void* output,
     if (output == nullptr) return paContinue;
     
     PAaudioLoopback* al = (PAaudioLoopback*)userData;
-    IringBuffer* rbuffer = al->m_ringbuffer;
+    SpscRingBuffer* rbuffer = al->m_ringbuffer;
     
+    StreamStats::Scope stats(al->m_stats, frameCount, al->m_outstreaminfo.sampleRate, statusFlags);
+
     if (rbuffer == nullptr) return paContinue;
 
     int numChannels = al->m_outstreaminfo.numChannel;
     bool fp = al->m_outstreaminfo.format == paFloat32;
 
-    int numSamples = numChannels * frameCount;
+    size_t numSamples = numChannels * frameCount;
+
+    // Occupancy before the read, a full ring means the producer is waiting on us
+    stats.ring_occupancy(rbuffer->getReadAvailable(), rbuffer->getBufferSize());
 
-    if (rbuffer->getReadAvailable() >= numSamples){
-        rbuffer->read(output, numSamples);
+    SpscRingBuffer::Regions regions;
+    if (rbuffer->peek_read(numSamples, regions) == numSamples){
+        size_t element_size = rbuffer->getElementSize();
+        memcpy(output, regions.data1, regions.size1 * element_size);
+        if (regions.size2)
+        {
+            memcpy((char*)output + regions.size1 * element_size, regions.data2, regions.size2 * element_size);
+        }
+        rbuffer->commit_read(numSamples);
     } else {
+        // Ring underrun, silence is played
+        stats.dropped(frameCount);
         memset(output, 0, (fp ? sizeof(float) : sizeof(int16_t)) * numSamples);
     }
 
@@ -51,7 +65,7 @@ bool PAaudioLoopback::set(int samplerate, float latency, int device_idx, int cha
         return false;
     }
 
-    m_ringbuffer = fp ? (IringBuffer *)(new ringBuffer<float>(ringbuffer_size)) : (IringBuffer *)(new ringBuffer<int16_t>(ringbuffer_size));
+    m_ringbuffer = fp ? (SpscRingBuffer *)(new spscRingBuffer<float>(ringbuffer_size)) : (SpscRingBuffer *)(new spscRingBuffer<int16_t>(ringbuffer_size));
     return true;
 }
 
@@ -77,6 +91,17 @@ bool PAaudioLoopback::add_data(const float data[], int size)
     return false;
 }
 
+bool PAaudioLoopback::add_raw_data(const void* data1, size_t size1, const void* data2, size_t size2)
+{
+    if (m_ringbuffer && (m_ringbuffer->getWriteAvailable() >= size1 + size2)){
+        m_ringbuffer->write(data1, size1);
+        if (size2) m_ringbuffer->write(data2, size2);
+        return true;
+    }
+
+    return false;
+}
+
 void PAaudioLoopback::pause(bool pause)
 {
     if (!m_outstream) return;
@@ -10,19 +10,33 @@ int PAaudioRecorder::recordCallback(
     void *userData)
 {
     // NumSamples = frameCount * numChannel
-    float *in = (float*)inputBuffer;
+    const char *in = (const char*)inputBuffer;
     PAaudioRecorder* ar = (PAaudioRecorder*)userData;
-    IringBuffer* rbuffer = ar->m_ring_buffer;
+    SpscRingBuffer* rbuffer = ar->m_ring_buffer;
 
-    int numSamplesToWrite = frameCount * ar->m_instreaminfo.numChannel;
+    StreamStats::Scope stats(ar->m_stats, frameCount, ar->m_instreaminfo.sampleRate, statusFlags);
 
+    if (in == nullptr || rbuffer == nullptr) return paContinue;
 
-    if (rbuffer->getWriteAvailable() < numSamplesToWrite)
+    size_t numSamplesToWrite = frameCount * ar->m_instreaminfo.numChannel;
+
+    // Drop the whole block if the consumer is late
+    SpscRingBuffer::Regions regions;
+    if (rbuffer->peek_write(numSamplesToWrite, regions) < numSamplesToWrite)
     {
+        stats.dropped(frameCount);
+        stats.ring_occupancy(rbuffer->getBufferSize(), rbuffer->getBufferSize());
         return paContinue;
     }
 
-    rbuffer->write(in, numSamplesToWrite);
+    size_t element_size = rbuffer->getElementSize();
+    memcpy(regions.data1, in, regions.size1 * element_size);
+    if (regions.size2)
+    {
+        memcpy(regions.data2, in + regions.size1 * element_size, regions.size2 * element_size);
+    }
+    rbuffer->commit_write(numSamplesToWrite);
+    stats.ring_occupancy(rbuffer->getReadAvailable(), rbuffer->getBufferSize());
 
     return paContinue;
 }
@@ -58,8 +72,8 @@ bool PAaudioRecorder::init(float latency, int device_idx, int samplerate)
 
     int bytes_per_sample = Pa_GetSampleSize(m_instreaminfo.format);
     int capacity = get_buffer_size(latency);
-    if (fp) m_ring_buffer = new ringBuffer<float>(capacity*2);
-    else m_ring_buffer = new ringBuffer<int16_t>(capacity*2);
+    if (fp) m_ring_buffer = new spscRingBuffer<float>(capacity*2);
+    else m_ring_buffer = new spscRingBuffer<int16_t>(capacity*2);
 
     return true;
 }
@@ -122,37 +136,22 @@ bool PAaudioRecorder::pause(bool pause)
     return true;
 }
 
-bool PAaudioRecorder::get_data(std::vector<float>& data, size_t size)
+bool PAaudioRecorder::peek_data(size_t size, SpscRingBuffer::Regions& regions)
 {
     if (!m_ring_buffer){
         return false;
     }
 
-    size_t sample_fill = m_ring_buffer->getReadAvailable();
-    if (sample_fill < size){
-        return false;
-    }
-
-    bool fp = m_manager.get_is_floatingpoint();
-
-    if (data.size() != size) data.resize(size, 0);
-
-    if (fp)
-    {
-        m_ring_buffer->read(data.data(), size);
-    }
-    else
-    {
-        std::vector<int16_t> intdata(size);
-        m_ring_buffer->read(intdata.data(), size);
+    return m_ring_buffer->peek_read(size, regions) == size;
+}
 
-        for (int i = 0; i < size; ++i)
-        {
-            data[i] = (float)intdata[i] / (float)INT16_MAX;
-        }
+void PAaudioRecorder::consume_data(size_t size)
+{
+    if (!m_ring_buffer){
+        return;
     }
 
-    return true;
+    m_ring_buffer->commit_read(size);
 }
 
 float PAaudioRecorder::get_ringbuffer_occupation()
@@ -0,0 +1,158 @@
+#include "audio_source.h"
+#include <utils.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+void RenderedAudioSource::restart()
+{
+    m_read_pos = m_write_pos = 0;
+    m_frames_read = 0;
+    m_end = false;
+}
+
+int RenderedAudioSource::get_available_samples()
+{
+    // Anything the consumer asks for can be rendered until the end of the data
+    if (!m_end) return INT_MAX;
+    return m_write_pos - m_read_pos;
+}
+
+bool RenderedAudioSource::peek_data(size_t size, SpscRingBuffer::Regions& regions)
+{
+    if (m_channels <= 0) return false;
+
+    size_t available = m_write_pos - m_read_pos;
+    if (available < size && !m_end)
+    {
+        const size_t needed = size - available;
+        if (m_buffer.size() - m_write_pos < needed)
+        {
+            // Consumed samples moved out, the buffer only grows to the largest request
+            memmove(m_buffer.data(), m_buffer.data() + m_read_pos, available * sizeof(float));
+            m_read_pos = 0;
+            m_write_pos = available;
+            if (m_buffer.size() < size) m_buffer.resize(size);
+        }
+
+        const int frames = (needed + m_channels - 1) / m_channels;
+        if (m_buffer.size() < m_write_pos + frames * m_channels) m_buffer.resize(m_write_pos + frames * m_channels);
+        const int rendered = render(m_buffer.data() + m_write_pos, frames);
+        m_write_pos += rendered * m_channels;
+        if (rendered < frames) m_end = true;
+        available = m_write_pos - m_read_pos;
+    }
+
+    if (available < size) return false;
+    regions.data1 = m_buffer.data() + m_read_pos;
+    regions.size1 = size;
+    regions.data2 = nullptr;
+    regions.size2 = 0;
+    return true;
+}
+
+void RenderedAudioSource::consume_data(size_t size)
+{
+    size = std::min(size, m_write_pos - m_read_pos);
+    m_read_pos += size;
+    m_frames_read += size / std::max(m_channels, 1);
+}
+
+void SyntheticAudioSource::init(const SyntheticSignal& signal)
+{
+    m_signal = signal;
+    m_samplerate = signal.samplerate;
+    m_channels = signal.channels;
+
+    m_gain = db_to_linear(signal.level_db);
+    m_harmonic_gains.clear();
+    for (double level : signal.harmonics_db) m_harmonic_gains.push_back(db_to_linear(level));
+    // Uniform noise in [-1, 1) has a RMS of 1/sqrt(3)
+    m_noise_gain = signal.noise_db > -300 ? db_to_linear(signal.noise_db) * sqrt(3.) : 0;
+
+    m_noise_generator.seek(0);
+    m_phase = m_wow_phase = 0;
+    m_frames_rendered = 0;
+    restart();
+}
+
+int SyntheticAudioSource::render(float* out, int frames)
+{
+    if (m_signal.duration > 0)
+    {
+        const uint64_t total = uint64_t(m_signal.duration * m_samplerate);
+        frames = (int)std::min<uint64_t>(frames, total - std::min(total, m_frames_rendered));
+    }
+
+    const double increment = m_signal.frequency / m_samplerate;
+    const double wow_increment = m_signal.wow_frequency / m_samplerate;
+    const double wow_depth = m_signal.wow_depth / 100.;
+    const int harmonics = m_harmonic_gains.size();
+
+    if (m_noise_gain > 0)
+    {
+        if ((int)m_noise.size() < frames * m_channels) m_noise.resize(frames * m_channels);
+        m_noise_generator.render(m_noise.data(), frames * m_channels);
+    }
+
+    for (int i = 0; i < frames; ++i)
+    {
+        const double phase = 2. * M_PI * m_phase;
+        double sample = sin(phase);
+        for (int h = 0; h < harmonics; ++h) sample += m_harmonic_gains[h] * sin((h + 2) * phase);
+        sample *= m_gain;
+
+        for (int c = 0; c < m_channels; ++c)
+        {
+            out[i * m_channels + c] = m_noise_gain > 0 ? sample + m_noise_gain * m_noise[i * m_channels + c] : sample;
+        }
+
+        // The phase stays in one cycle, long runs keep their precision
+        m_phase += increment * (1. + wow_depth * sin(2. * M_PI * m_wow_phase));
+        m_phase -= floor(m_phase);
+        m_wow_phase += wow_increment;
+        m_wow_phase -= floor(m_wow_phase);
+    }
+    m_frames_rendered += frames;
+    return frames;
+}
+
+bool WavFileAudioSource::open(const std::string& path, bool loop)
+{
+    if (!m_file.open(path)) return false;
+
+    m_samplerate = m_file.samplerate();
+    m_channels = std::min(m_file.channels(), 2);
+    m_position = 0;
+    m_loop = loop;
+    restart();
+    return true;
+}
+
+int WavFileAudioSource::render(float* out, int frames)
+{
+    if (!m_file.is_open()) return 0;
+
+    int done = 0;
+    while (done < frames)
+    {
+        if (m_position == m_file.frames())
+        {
+            if (!m_loop) break;
+            m_position = 0;
+        }
+
+        const int count = (int)std::min<uint64_t>(frames - done, m_file.frames() - m_position);
+        if ((int)m_channel_data.size() < count) m_channel_data.resize(count);
+        for (int c = 0; c < m_channels; ++c)
+        {
+            m_file.read_channel(c, m_position, count, m_channel_data.data());
+            float* channel_out = out + done * m_channels + c;
+            for (int i = 0; i < count; ++i) channel_out[i * m_channels] = m_channel_data[i];
+        }
+        m_position += count;
+        done += count;
+    }
+    return done;
+}
@@ -0,0 +1,43 @@
+#define _USE_MATH_DEFINES
+#include <log_sweep.h>
+#include <cmath>
+#include <algorithm>
+
+// Fade out length, the fade in lasts two periods of the start frequency
+static const double SWEEP_FADE_OUT = 0.005;
+
+double LogSweep::rate(double start_freq, double end_freq, double duration)
+{
+    return duration / log(end_freq / start_freq);
+}
+
+void LogSweep::render(double start_freq, double end_freq, double duration, int samplerate, std::vector<double>& out)
+{
+    const int size = std::max(int(duration * samplerate), 0);
+    const double L = rate(start_freq, end_freq, duration);
+    const double omega = 2. * M_PI * start_freq * L;
+    const int fade_in = std::min(int(2. / start_freq * samplerate), size / 10);
+    const int fade_out = std::min(int(SWEEP_FADE_OUT * samplerate), size / 10);
+
+    out.resize(size);
+    for (int i = 0; i < size; ++i)
+    {
+        const double t = double(i) / samplerate;
+        double gain = 1.;
+        if (i < fade_in) gain = 0.5 - 0.5 * cos(M_PI * i / fade_in);
+        else if (i >= size - fade_out) gain = 0.5 - 0.5 * cos(M_PI * (size - i) / fade_out);
+        out[i] = gain * sin(omega * (exp(t / L) - 1.));
+    }
+}
+
+void LogSweep::init(double start_freq, double end_freq, double duration, int samplerate)
+{
+    m_start_freq = start_freq;
+    m_end_freq = end_freq;
+    m_duration = duration;
+    m_position = 0;
+
+    std::vector<double> sweep;
+    render(start_freq, end_freq, duration, samplerate, sweep);
+    m_table.assign(sweep.begin(), sweep.end());
+}
@@ -0,0 +1,110 @@
+#define _USE_MATH_DEFINES
+#include <multitone.h>
+#include <cmath>
+#include <algorithm>
+
+// Clipping level of the phase optimisation, relative to the multitone RMS
+static const double CLIP_RMS_RATIO = 1.2;
+
+std::vector<int> MultitoneTable::log_spaced_bins(int period, int samplerate, int tones, double min_freq, double max_freq, int min_spacing)
+{
+    std::vector<int> bins;
+    if (period <= 0 || samplerate <= 0 || tones <= 0) return bins;
+
+    const double bin_hz = double(samplerate) / period;
+    const int last_bin = std::min((int)lround(max_freq / bin_hz), period / 2 - min_spacing);
+    const double log_min = log10(std::max(min_freq, bin_hz));
+    const double log_step = tones > 1 ? (log10(max_freq) - log_min) / (tones - 1) : 0.;
+    for (int i = 0; i < tones; ++i)
+    {
+        int bin = std::max((int)lround(pow(10., log_min + log_step * i) / bin_hz), 1);
+        if (!bins.empty()) bin = std::max(bin, bins.back() + min_spacing);
+        if (bin > last_bin) break;
+        bins.push_back(bin);
+    }
+    return bins;
+}
+
+void MultitoneTable::init(const std::vector<int>& bins, int period, int samplerate, int iterations)
+{
+    m_bins = bins;
+    m_samplerate = samplerate;
+    m_position = 0;
+    m_table.assign(period, 0.f);
+    const int tones = m_bins.size();
+    if (tones == 0 || period <= 0) return;
+
+    // One period of cos/sin, bin k at sample n is entry (k * n) mod period
+    std::vector<double> cos_table(period), sin_table(period);
+    for (int n = 0; n < period; ++n)
+    {
+        cos_table[n] = cos(2. * M_PI * n / period);
+        sin_table[n] = sin(2. * M_PI * n / period);
+    }
+
+    // Schroeder phases generalized to uneven spacing : the group delay grows linearly
+    // with the tone index, so the stimulus behaves like a chirp spreading the tones over the period
+    std::vector<double> phases(tones, 0.);
+    for (int k = 1; k < tones; ++k) phases[k] = phases[k-1] - 2. * M_PI * (m_bins[k] - m_bins[k-1]) * double(k) / tones;
+
+    auto synthesize = [&](std::vector<double>& out) {
+        std::fill(out.begin(), out.end(), 0.);
+        for (int k = 0; k < tones; ++k)
+        {
+            const double c = cos(phases[k]), s = sin(phases[k]);
+            for (int n = 0, index = 0; n < period; ++n)
+            {
+                out[n] += c * cos_table[index] - s * sin_table[index];
+                index += m_bins[k];
+                if (index >= period) index -= period;
+            }
+        }
+        double peak = 0;
+        for (double v : out) peak = std::max(peak, fabs(v));
+        return peak;
+    };
+
+    // Clip and re-extract the phases, the amplitudes are kept equal
+    // With 30 log spaced tones the crest factor goes down by 1 to 2dB
+    std::vector<double> signal(period);
+    std::vector<double> best_phases = phases;
+    double best_peak = synthesize(signal);
+    const double clip = CLIP_RMS_RATIO * sqrt(tones * 0.5);
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (double& v : signal) v = std::min(std::max(v, -clip), clip);
+
+        for (int k = 0; k < tones; ++k)
+        {
+            double re = 0, im = 0;
+            for (int n = 0, index = 0; n < period; ++n)
+            {
+                re += signal[n] * cos_table[index];
+                im += signal[n] * sin_table[index];
+                index += m_bins[k];
+                if (index >= period) index -= period;
+            }
+            phases[k] = atan2(-im, re);
+        }
+
+        const double peak = synthesize(signal);
+        if (peak < best_peak)
+        {
+            best_peak = peak;
+            best_phases = phases;
+        }
+    }
+
+    phases = best_phases;
+    best_peak = synthesize(signal);
+    m_tone_amplitude = 1. / best_peak;
+    m_crest_factor = best_peak / sqrt(tones * 0.5);
+    for (int n = 0; n < period; ++n) m_table[n] = float(signal[n] * m_tone_amplitude);
+}
+
+std::vector<double> MultitoneTable::frequencies() const
+{
+    std::vector<double> freqs(m_bins.size());
+    for (size_t k = 0; k < m_bins.size(); ++k) freqs[k] = double(m_bins[k]) * m_samplerate / m_table.size();
+    return freqs;
+}
@@ -0,0 +1,302 @@
+#include "wav_file.h"
+#include <cstring>
+#include <vector>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+void log_message(const char* format, ...);
+
+static const uint16_t WAVE_FORMAT_PCM = 1;
+static const uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+static const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+// ds64 payload : RIFF size, data size, sample count (64 bits each), table length
+static const uint32_t DS64_SIZE = 28;
+
+static void put_u16(std::vector<uint8_t>& out, uint16_t v)
+{
+    out.push_back(v & 0xFF);
+    out.push_back(v >> 8);
+}
+
+static void put_u32(std::vector<uint8_t>& out, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) out.push_back((v >> (8 * i)) & 0xFF);
+}
+
+static void put_u64(std::vector<uint8_t>& out, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) out.push_back((v >> (8 * i)) & 0xFF);
+}
+
+static void put_id(std::vector<uint8_t>& out, const char* id)
+{
+    out.insert(out.end(), id, id + 4);
+}
+
+bool WavWriter::write_header(bool rf64)
+{
+    const bool fp = m_floatingpoint;
+    const uint16_t bits = fp ? 32 : 16;
+    const uint16_t block_align = m_channels * bits / 8;
+    const uint64_t frames = m_data_bytes / block_align;
+    // RIFF size counts everything after the RIFF size field, including the data padding byte
+    const uint64_t riff_size = WAV_DATA_ALIGNMENT - 8 + m_data_bytes + (m_data_bytes & 1);
+
+    std::vector<uint8_t> header;
+    header.reserve(WAV_DATA_ALIGNMENT);
+    put_id(header, rf64 ? "RF64" : "RIFF");
+    put_u32(header, rf64 ? 0xFFFFFFFF : (uint32_t)riff_size);
+    put_id(header, "WAVE");
+
+    // Reserved for the ds64 chunk, a plain JUNK chunk until the sizes overflow
+    put_id(header, rf64 ? "ds64" : "JUNK");
+    put_u32(header, DS64_SIZE);
+    put_u64(header, rf64 ? riff_size : 0);
+    put_u64(header, rf64 ? m_data_bytes : 0);
+    put_u64(header, rf64 ? frames : 0);
+    put_u32(header, 0);
+
+    put_id(header, "fmt ");
+    put_u32(header, fp ? 18 : 16);
+    put_u16(header, fp ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM);
+    put_u16(header, m_channels);
+    put_u32(header, m_samplerate);
+    put_u32(header, m_samplerate * block_align);
+    put_u16(header, block_align);
+    put_u16(header, bits);
+    if (fp)
+    {
+        // cbSize, non PCM formats also need the fact chunk
+        put_u16(header, 0);
+        put_id(header, "fact");
+        put_u32(header, 4);
+        put_u32(header, rf64 || frames > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)frames);
+    }
+
+    // Padding up to the data alignment, minus the JUNK and data chunk headers
+    put_id(header, "JUNK");
+    put_u32(header, WAV_DATA_ALIGNMENT - header.size() - 4 - 8);
+    header.resize(WAV_DATA_ALIGNMENT - 8, 0);
+
+    put_id(header, "data");
+    put_u32(header, rf64 ? 0xFFFFFFFF : (uint32_t)m_data_bytes);
+
+    return fseek(m_file, 0, SEEK_SET) == 0 && fwrite(header.data(), 1, header.size(), m_file) == header.size();
+}
+
+bool WavWriter::open(const std::string& path, int samplerate, int channels, bool floatingpoint)
+{
+    close();
+
+    m_file = fopen(path.c_str(), "wb");
+    if (m_file == nullptr)
+    {
+        log_message("Cannot open %s for writing", path.c_str());
+        return false;
+    }
+    // The caller writes large blocks, no need for the stdio copy
+    setvbuf(m_file, nullptr, _IONBF, 0);
+
+    m_samplerate = samplerate;
+    m_channels = channels;
+    m_floatingpoint = floatingpoint;
+    m_data_bytes = 0;
+
+    if (!write_header(false))
+    {
+        log_message("Cannot write %s", path.c_str());
+        fclose(m_file);
+        m_file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool WavWriter::write(const void* data, size_t size)
+{
+    if (m_file == nullptr) return false;
+    const size_t written = fwrite(data, 1, size, m_file);
+    m_data_bytes += written;
+    return written == size;
+}
+
+bool WavWriter::close()
+{
+    if (m_file == nullptr) return false;
+
+    bool ok = true;
+    if (m_data_bytes & 1) ok = fputc(0, m_file) != EOF;
+
+    // Sizes over 4GB don't fit in the RIFF header
+    const bool rf64 = WAV_DATA_ALIGNMENT - 8 + m_data_bytes + 1 > 0xFFFFFFFF;
+    ok = write_header(rf64) && ok;
+    ok = fclose(m_file) == 0 && ok;
+    m_file = nullptr;
+    return ok;
+}
+
+static uint16_t get_u16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_u64(const uint8_t* p)
+{
+    return get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+bool MappedWavFile::map(const std::string& path)
+{
+#ifdef WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    m_file_handle = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) return false;
+    m_map_size = size.QuadPart;
+
+    m_mapping_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping_handle == NULL) return false;
+    m_map = (const uint8_t*)MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    return m_map != nullptr;
+#else
+    m_fd = ::open(path.c_str(), O_RDONLY);
+    if (m_fd < 0) return false;
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || st.st_size == 0) return false;
+    m_map_size = st.st_size;
+
+    void* map = mmap(nullptr, m_map_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (map == MAP_FAILED) return false;
+    m_map = (const uint8_t*)map;
+    // Each reader goes forward through its own part of the file
+    madvise(map, m_map_size, MADV_SEQUENTIAL);
+    return true;
+#endif
+}
+
+bool MappedWavFile::parse()
+{
+    if (m_map_size < 12) return false;
+    const bool rf64 = memcmp(m_map, "RF64", 4) == 0;
+    if ((!rf64 && memcmp(m_map, "RIFF", 4) != 0) || memcmp(m_map + 8, "WAVE", 4) != 0) return false;
+
+    uint64_t ds64_data_size = 0;
+    bool fmt_found = false;
+    uint64_t pos = 12;
+    while (pos + 8 <= m_map_size)
+    {
+        const uint8_t* chunk = m_map + pos;
+        uint64_t size = get_u32(chunk + 4);
+
+        if (memcmp(chunk, "ds64", 4) == 0 && size >= 24 && pos + 8 + size <= m_map_size)
+        {
+            ds64_data_size = get_u64(chunk + 16);
+        }
+        else if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && pos + 8 + size <= m_map_size)
+        {
+            uint16_t format = get_u16(chunk + 8);
+            m_channels = get_u16(chunk + 10);
+            m_samplerate = get_u32(chunk + 12);
+            m_bytes_per_sample = get_u16(chunk + 22) / 8;
+            // The sub format GUID starts with the format tag
+            if (format == WAVE_FORMAT_EXTENSIBLE && size >= 40) format = get_u16(chunk + 32);
+            m_floatingpoint = format == WAVE_FORMAT_IEEE_FLOAT;
+            fmt_found = (format == WAVE_FORMAT_PCM && m_bytes_per_sample >= 2 && m_bytes_per_sample <= 4) ||
+                        (m_floatingpoint && m_bytes_per_sample == 4);
+            if (!fmt_found) log_message("Unsupported WAV format %i, %i bits", format, m_bytes_per_sample * 8);
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            if (!fmt_found || m_channels <= 0 || m_samplerate <= 0) return false;
+            const uint64_t available = m_map_size - pos - 8;
+            if (rf64 && size == 0xFFFFFFFF) size = ds64_data_size;
+            if (size == 0 || size > available) size = available;
+
+            m_data = chunk + 8;
+            m_frames = size / (m_channels * m_bytes_per_sample);
+            return m_frames > 0;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+bool MappedWavFile::open(const std::string& path)
+{
+    close();
+
+    if (!map(path))
+    {
+        log_message("Cannot map %s", path.c_str());
+        close();
+        return false;
+    }
+    if (!parse())
+    {
+        log_message("%s is not a supported WAV file", path.c_str());
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedWavFile::close()
+{
+#ifdef WIN32
+    if (m_map) UnmapViewOfFile(m_map);
+    if (m_mapping_handle) CloseHandle(m_mapping_handle);
+    if (m_file_handle) CloseHandle(m_file_handle);
+    m_file_handle = m_mapping_handle = nullptr;
+#else
+    if (m_map) munmap((void*)m_map, m_map_size);
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+#endif
+    m_map = m_data = nullptr;
+    m_map_size = m_frames = 0;
+    m_samplerate = m_channels = m_bytes_per_sample = 0;
+}
+
+void MappedWavFile::read_channel(int channel, uint64_t first_frame, int count, double* out) const
+{
+    const size_t stride = m_channels * m_bytes_per_sample;
+    const uint8_t* in = m_data + first_frame * stride + channel * m_bytes_per_sample;
+
+    if (m_floatingpoint)
+    {
+        for (int i = 0; i < count; ++i, in += stride)
+        {
+            float sample;
+            memcpy(&sample, in, sizeof(float));
+            out[i] = sample;
+        }
+    }
+    else if (m_bytes_per_sample == 2)
+    {
+        for (int i = 0; i < count; ++i, in += stride) out[i] = (int16_t)get_u16(in) * (1. / 32768.);
+    }
+    else if (m_bytes_per_sample == 3)
+    {
+        // Sign extended from the top byte
+        for (int i = 0; i < count; ++i, in += stride) out[i] = (int32_t)((in[0] << 8) | (in[1] << 16) | ((uint32_t)in[2] << 24)) * (1. / 2147483648.);
+    }
+    else
+    {
+        for (int i = 0; i < count; ++i, in += stride) out[i] = (int32_t)get_u32(in) * (1. / 2147483648.);
+    }
+}
@@ -0,0 +1,121 @@
+#define _USE_MATH_DEFINES
+#include <wavetable_oscillator.h>
+#include <cmath>
+#include <algorithm>
+
+static const double LOWEST_OCTAVE_FREQ = 20.;
+// Linear interpolation stays clean if the table is well oversampled
+static const int MAX_HARMONICS = WavetableOscillator::TABLE_SIZE / 4;
+
+void WavetableOscillator::init(double samplerate)
+{
+    m_samplerate = samplerate;
+    m_phase = 0;
+    m_frequency = m_target_frequency = 0;
+    m_frequency_steps = 0;
+
+    std::vector<double> sine(TABLE_SIZE);
+    for (int i = 0; i < TABLE_SIZE; ++i) sine[i] = sin(2. * M_PI * i / TABLE_SIZE);
+
+    std::vector<double> table(TABLE_SIZE);
+    for (int waveform = 0; waveform < WAVEFORM_COUNT; ++waveform)
+    {
+        m_tables[waveform].resize(OCTAVES * (TABLE_SIZE + 1));
+        double peak = 0;
+        for (int octave = 0; octave < OCTAVES; ++octave)
+        {
+            // Harmonics below Nyquist at the top of the octave
+            const double top = LOWEST_OCTAVE_FREQ * (2 << octave);
+            const int harmonics = waveform == SINE ? 1 : std::min(std::max(int(samplerate * 0.5 / top), 1), MAX_HARMONICS);
+
+            std::fill(table.begin(), table.end(), 0.);
+            for (int k = 1; k <= harmonics; ++k)
+            {
+                double amplitude = 0;
+                if (waveform == SINE) amplitude = 1.;
+                // Odd harmonics only, same phase as the naive square (high first) and triangle (rising from 0)
+                else if (waveform == SQUARE && (k & 1)) amplitude = 4. / (M_PI * k);
+                else if (waveform == TRIANGLE && (k & 1)) amplitude = ((k & 2) ? -8. : 8.) / (M_PI * M_PI * k * k);
+                if (amplitude == 0) continue;
+                for (int i = 0, index = 0; i < TABLE_SIZE; ++i)
+                {
+                    table[i] += amplitude * sine[index];
+                    index += k;
+                    if (index >= TABLE_SIZE) index -= TABLE_SIZE;
+                }
+            }
+
+            float* out = &m_tables[waveform][octave * (TABLE_SIZE + 1)];
+            for (int i = 0; i < TABLE_SIZE; ++i)
+            {
+                out[i] = table[i];
+                peak = std::max(peak, fabs(table[i]));
+            }
+            out[TABLE_SIZE] = out[0];
+        }
+
+        // Same scale for all octaves, the Gibbs overshoot of the square must not clip
+        const float scale = 1. / peak;
+        for (float& v : m_tables[waveform]) v *= scale;
+    }
+}
+
+const float* WavetableOscillator::octave_table(double frequency) const
+{
+    int octave = 0;
+    if (frequency >= LOWEST_OCTAVE_FREQ * 2.)
+    {
+        frexp(frequency / LOWEST_OCTAVE_FREQ, &octave);
+        octave = std::min(octave - 1, OCTAVES - 1);
+    }
+    return &m_tables[m_waveform][octave * (TABLE_SIZE + 1)];
+}
+
+void WavetableOscillator::set_frequency(double frequency, double duration)
+{
+    m_target_frequency = frequency;
+    m_frequency_steps = int(duration * m_samplerate);
+    if (m_frequency_steps <= 0) m_frequency = frequency;
+    else m_frequency_step = (frequency - m_frequency) / m_frequency_steps;
+}
+
+void WavetableOscillator::render(float* out, int frames)
+{
+    if (m_samplerate <= 0 || m_tables[m_waveform].empty())
+    {
+        std::fill(out, out + frames, 0.f);
+        return;
+    }
+
+    const double inv_samplerate = 1. / m_samplerate;
+    int i = 0;
+    // Frequency transition, sample by sample until it is done
+    for (; i < frames && m_frequency_steps > 0; ++i)
+    {
+        if (--m_frequency_steps == 0) m_frequency = m_target_frequency;
+        else m_frequency += m_frequency_step;
+
+        const float* table = octave_table(m_frequency);
+        const double position = m_phase * TABLE_SIZE;
+        const int index = int(position);
+        const double frac = position - index;
+        out[i] = table[index] + frac * (table[index + 1] - table[index]);
+        m_phase += m_frequency * inv_samplerate;
+        m_phase -= floor(m_phase);
+    }
+
+    // Steady state
+    const float* table = octave_table(m_frequency);
+    const double increment = m_frequency * inv_samplerate;
+    double phase = m_phase;
+    for (; i < frames; ++i)
+    {
+        const double position = phase * TABLE_SIZE;
+        const int index = int(position);
+        const double frac = position - index;
+        out[i] = table[index] + frac * (table[index + 1] - table[index]);
+        phase += increment;
+        if (phase >= 1.) phase -= 1.;
+    }
+    m_phase = phase;
+}
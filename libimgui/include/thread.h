@@ -46,7 +46,12 @@ public:
 #ifdef WIN32
         InitializeCriticalSection(&m_mutex);
 #else
-        pthread_mutex_init(&m_mutex, NULL);
+        // Recursive like the win32 critical section
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&m_mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
 #endif
     }
     ~ThreadMutex()
@@ -113,6 +113,8 @@ public:
 	void set_maximum_window_size(int x, int y);
 	void set_imgui_context();
 	bool is_shown();
+	// File next to the window .ini, empty if there is no config directory
+	std::string get_config_file_path(const std::string& extension);
 
 	void get_configuration_int(std::map<std::string, int>& );
 	void set_configuration_int(std::string, int);
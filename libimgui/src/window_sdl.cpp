@@ -342,6 +342,13 @@ bool Window_SDL::is_shown()
 	return _impl->_is_shown;
 }
 
+std::string Window_SDL::get_config_file_path(const std::string& extension)
+{
+	std::string path = _impl->_inifilename;
+	if (path.size() < 4) return "";
+	return path.substr(0, path.size() - 4) + extension;
+}
+
 unsigned int Window_SDL::get_windid()
 {
 	return SDL_GetWindowID(_impl->_window);
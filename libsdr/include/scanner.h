@@ -120,6 +120,9 @@ private:
 
 	double (*m_window_fn)(int, int);
 
+	// The fixed point FFT is timed by bench/tapetools_bench.cpp
+	friend class ScannerBenchmark;
+
 	void make_sine_table(int size);
 	int  fix_fft(int16_t iq[], int m);
 	void rms_power(struct Tuning_state *ts);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define DSP_KERNELS_SSE2
+#endif
+#if defined(__aarch64__)
+#define DSP_KERNELS_NEON
+#endif
+// AVX2 kernels are selected at runtime, the rest of the tree is built for the baseline ISA
+#if defined(DSP_KERNELS_SSE2) && defined(__GNUC__)
+#define DSP_KERNELS_AVX2
+#endif
+
+/*
+ * Fused capture kernel : deinterleave the first two channels of an interleaved block,
+ * convert to double and apply the gain (out_*), apply the window (win_*)
+ * and accumulate the sum of squares of the gained signal (sumsq[0..1])
+ * Right channel pointers are ignored when channels == 1
+ * int16 samples are scaled by gain / INT16_MAX
+ * The float window variants feed the single precision FFT, the time domain output stays double
+ */
+void deinterleave_capture(const float* in, int frames, int channels, double gain, const double* window,
+                          double* out_l, double* out_r, double* win_l, double* win_r, double sumsq[2]);
+void deinterleave_capture(const int16_t* in, int frames, int channels, double gain, const double* window,
+                          double* out_l, double* out_r, double* win_l, double* win_r, double sumsq[2]);
+void deinterleave_capture(const float* in, int frames, int channels, double gain, const float* window,
+                          double* out_l, double* out_r, float* win_l, float* win_r, double sumsq[2]);
+void deinterleave_capture(const int16_t* in, int frames, int channels, double gain, const float* window,
+                          double* out_l, double* out_r, float* win_l, float* win_r, double sumsq[2]);
+
+/*
+ * Capture kernel without the window : deinterleave the first two channels, convert to double
+ * and apply the gain, same conventions as deinterleave_capture
+ */
+void deinterleave_gain(const float* in, int frames, int channels, double gain, double* out_l, double* out_r);
+void deinterleave_gain(const int16_t* in, int frames, int channels, double gain, double* out_l, double* out_r);
+
+/*
+ * out = in * window, returns the sum of squares of in
+ */
+double apply_window(const double* in, const double* window, double* out, int size);
+double apply_window(const double* in, const float* window, float* out, int size);
+
+/*
+ * FFT display kernel : out = max(10 * log10(power) + offset, floor_db) from the power |X|^2,
+ * NaN and zero bins give floor_db
+ * log10 is approximated (error below 1e-6 dB), returns the sum of out
+ */
+double power_to_db(const double* power, int size, double offset, double floor_db, double* out);
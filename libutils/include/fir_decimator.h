@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+/*
+ * Decimating low-pass FIR, only the kept output samples are computed
+ * Kaiser windowed sinc, the tap count comes from the transition band and stop band attenuation.
+ * A cutoff at a quarter of the input rate gives a half-band filter, its zero taps are skipped
+ * and the symmetric taps are folded (one multiply per tap pair).
+ * All channels share the taps, each one keeps its own history
+ */
+class FirDecimator
+{
+    int     m_factor = 1;
+    int     m_channels = 1;
+    int     m_length = 1;
+    int     m_phase = 0;
+    std::vector<double> m_taps;
+
+    // Non zero tap pairs (k, length - 1 - k), the center tap apart
+    std::vector<int>    m_pair_index;
+    std::vector<double> m_pair_taps;
+    double  m_center_tap = 0;
+
+    // Per channel : length - 1 samples of history followed by the current block
+    std::vector<double> m_buffer;
+    int     m_buffer_stride = 0;
+
+public:
+    FirDecimator(){}
+
+    // Frequencies are relative to the input samplerate (0 .. 0.5)
+    void init(int factor, double passband, double stopband, double attenuation_db, int channels = 1);
+    void reset();
+
+    int factor() const {return m_factor;}
+    int length() const {return m_length;}
+
+    // in/out hold one pointer per channel, out needs room for size / factor + 1 samples
+    // Returns the number of output samples, in and out may alias
+    int process(const double* const* in, int size, double* const* out);
+};
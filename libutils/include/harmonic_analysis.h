@@ -0,0 +1,37 @@
+#pragma once
+
+#include "peak_interpolator.h"
+#include "spectrum_integrator.h"
+
+// Fundamental and harmonics taken into account in the THD
+const int THD_HARMONICS = 8;
+
+/*
+ * THD and THD+N of one power spectrum |X|^2 (half spectrum, DC first)
+ * Shared by the realtime analysis and the file analysis, the power scale doesn't matter
+ * since every result is a ratio
+ */
+struct HarmonicAnalysis
+{
+    int     found_peaks = 0;
+    int     harmonics_idx[THD_HARMONICS] = {0};
+    double  harmonics_freq[THD_HARMONICS] = {0};
+    double  thd = 0;                // %
+    double  thdn = 0;               // %
+    double  thdn_db = 0;
+    double  thdn_audio_band = 0;    // %, 20Hz - 20kHz
+    double  thdn_a_weighted = 0;    // %
+    double  fft_rms = 0;
+    // Skirts of the fundamental, excluded from the noise
+    int     fund_idx_range_min = 0;
+    int     fund_idx_range_max = 0;
+
+    // The fundamental is the strongest bin, the harmonics are searched around its multiples
+    void compute_thd(const double* power, int bins, double bin_hz, const PeakInterpolator& interpolator);
+
+    /*
+     * Needs compute_thd() first, spectrum is updated with power * energy_correction
+     * and then queried for the noise bands
+     */
+    void compute_thdn(const double* power, int bins, double energy_correction, SpectrumIntegrator& spectrum);
+};
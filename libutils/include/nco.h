@@ -0,0 +1,29 @@
+#pragma once
+
+/*
+ * Numerically controlled oscillator and IQ mixer
+ * The local oscillator is a unit phasor rotated by a constant step instead of cos()/sin() per sample.
+ * NCO_LANES phasors run side by side (lane k at phase + k * step, all rotated by NCO_LANES * step)
+ * so the recurrence has no serial dependency and vectorises, they are renormalised regularly
+ */
+const int NCO_LANES = 4;
+
+class Nco
+{
+    double  m_re[NCO_LANES];
+    double  m_im[NCO_LANES];
+    double  m_step_re = 1, m_step_im = 0;   // one sample rotation
+    double  m_lanes_re = 1, m_lanes_im = 0; // NCO_LANES samples rotation
+
+    void advance(int samples);
+    void renormalize();
+
+public:
+    Nco();
+
+    void set_frequency(double frequency, double samplerate);
+    void reset(double phase = 0);
+
+    // out_i = in * cos(phase), out_q = in * sin(phase), the phase keeps running between calls
+    void mix(const double* in, double* out_i, double* out_q, int size);
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+ * Sub-bin spectral peak estimator
+ * Gaussian interpolation (parabola through the log power of the peak bin and its neighbours),
+ * its bias for the actual window shape is removed with a correction table built from the
+ * window spectrum : estimated offset -> true offset, and the scalloping loss at that offset
+ */
+class PeakInterpolator
+{
+public:
+    static const int TABLE_SIZE = 129;
+
+private:
+    // Indexed by the true offset, -0.5 .. 0.5 bin
+    double  m_estimate[TABLE_SIZE];
+    double  m_scalloping[TABLE_SIZE];
+    bool    m_monotonic = false;
+
+    static double gaussian_offset(double left, double center, double right);
+    double true_offset(double estimate, double& scalloping) const;
+
+public:
+    PeakInterpolator();
+
+    // Builds the correction table for a window function
+    void init(double (*window_fn)(int, int));
+
+    /*
+     * Highest bin of power[] within expected_bin +/- radius, refined to a fractional bin
+     * peak_power is the power corrected for the scalloping loss
+     * Returns the integer peak bin
+     */
+    int locate(const double* power, int size, double expected_bin, int radius, double& bin, double& peak_power) const;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+ * Power spectrum averaging, the averaged power |X|^2 is kept in a preallocated buffer
+ * LINEAR      : mean of N spectra, the last complete mean is kept while the next one accumulates
+ * EXPONENTIAL : P += (Pnew - P) / N
+ * PEAK_HOLD   : maximum of each bin until reset()
+ * The power of the last added spectrum is kept as well, whatever the mode
+ */
+class SpectrumAverager
+{
+public:
+    enum Mode
+    {
+        NONE = 0,
+        LINEAR,
+        EXPONENTIAL,
+        PEAK_HOLD
+    };
+
+private:
+    int     m_size = 0;
+    double  *m_power = nullptr;
+    double  *m_sum = nullptr;
+    double  *m_last = nullptr;
+    int     m_mode = NONE;
+    int     m_length = 1;
+    int     m_count = 0;
+    bool    m_linear_complete = false;
+
+public:
+    SpectrumAverager(){}
+    ~SpectrumAverager();
+
+    void init(int size);
+    void destroy();
+    void reset();
+    void set_mode(int mode, int length);
+
+    // Interleaved complex bins (fftw_complex/fftwf_complex layout), double or float
+    template<class T>
+    void add(const T* spectrum);
+
+    const double* power() const {return m_power;}
+    const double* last_power() const {return m_last;}
+    int size() const {return m_size;}
+    // Number of spectra in the current average
+    int count() const {return m_count;}
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+/*
+ * Cumulative power of a spectrum, the power of any band is then a single subtraction
+ * The prefix sums are compensated (the rounding error of each addition is kept apart)
+ * so a noise band next to a fundamental 140dB above it keeps its precision.
+ * An A-weighted prefix is built in the same pass
+ */
+class SpectrumIntegrator
+{
+    int     m_size = 0;
+    double  m_bin_hz = 0;
+    double  *m_prefix = nullptr;
+    double  *m_prefix_error = nullptr;
+    double  *m_weighted = nullptr;
+    double  *m_weighted_error = nullptr;
+    double  *m_a_weighting = nullptr;
+
+public:
+    SpectrumIntegrator(){}
+    ~SpectrumIntegrator();
+
+    // size bins, bin i centered on i * bin_hz
+    void init(int size, double bin_hz);
+    void destroy();
+
+    // Integrates power[0 .. size[ * scale
+    void update(const double* power, double scale);
+
+    // Power of bins [first, last[, clamped to the spectrum
+    double band(int first, int last) const;
+    double weighted_band(int first, int last) const;
+
+    // First bin at or above frequency
+    int bin(double frequency) const;
+    int size() const {return m_size;}
+};
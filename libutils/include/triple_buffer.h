@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+
+/*
+ * Lock-free single producer / single consumer frame exchange
+ * The producer fills back() and publish()es it, the consumer fetch()es the newest published
+ * frame and reads front() until its next fetch(). Each side owns one of the three slots,
+ * the third one is exchanged with a single atomic operation : the producer never waits for
+ * the consumer, the consumer never sees a frame being written, unread frames are dropped
+ * Slots are recycled, a frame must be fully rewritten or only hold data that is always set
+ */
+template<class T>
+class TripleBuffer
+{
+    // The exchanged slot index, FRESH is set when it holds a frame not fetched yet
+    static const int FRESH = 4;
+    static const int INDEX_MASK = 3;
+
+    T                   m_slots[3];
+    int                 m_back = 0;     // Producer side only
+    int                 m_front = 1;    // Consumer side only
+    std::atomic<int>    m_middle{2};
+
+public:
+    // Producer side
+    T&   back(){return m_slots[m_back];}
+    void publish()
+    {
+        m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Consumer side, returns true if front() changed
+    bool fetch()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T& front() const {return m_slots[m_front];}
+
+    // Applies fn to the three slots, neither the producer nor the consumer may run meanwhile
+    template<class F>
+    void for_each_slot(F fn)
+    {
+        for (T& slot : m_slots) fn(slot);
+    }
+};
@@ -0,0 +1,618 @@
+#include "dsp_kernels.h"
+
+#ifdef DSP_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef DSP_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+#ifdef DSP_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+/*
+ * The time domain output is always double, the windowed output (W) is either double or float
+ */
+template<class T, class W>
+static inline void deinterleave_capture_scalar(const T* in, int start, int frames, int channels, double gain, const W* window,
+                          double* out_l, double* out_r, W* win_l, W* win_r, double sumsq[2])
+{
+    double sum_l = 0, sum_r = 0;
+    for (int i = start; i < frames; ++i)
+    {
+        double left = in[i*channels] * gain;
+        out_l[i] = left;
+        win_l[i] = (W)left * window[i];
+        sum_l += left * left;
+        if (channels > 1)
+        {
+            double right = in[i*channels+1] * gain;
+            out_r[i] = right;
+            win_r[i] = (W)right * window[i];
+            sum_r += right * right;
+        }
+    }
+    sumsq[0] += sum_l;
+    sumsq[1] += sum_r;
+}
+
+#ifdef DSP_KERNELS_SSE2
+// Four mono samples
+static inline void store_channel_sse2(__m128 samples, __m128d gain, const double* window, double* out, double* win, __m128d& sum)
+{
+    __m128d lo = _mm_mul_pd(_mm_cvtps_pd(samples), gain);
+    __m128d hi = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(samples, samples)), gain);
+    _mm_storeu_pd(out, lo);
+    _mm_storeu_pd(out + 2, hi);
+    _mm_storeu_pd(win, _mm_mul_pd(lo, _mm_loadu_pd(window)));
+    _mm_storeu_pd(win + 2, _mm_mul_pd(hi, _mm_loadu_pd(window + 2)));
+    sum = _mm_add_pd(sum, _mm_add_pd(_mm_mul_pd(lo, lo), _mm_mul_pd(hi, hi)));
+}
+
+static inline void store_channel_sse2(__m128 samples, __m128d gain, const float* window, double* out, float* win, __m128d& sum)
+{
+    __m128d lo = _mm_mul_pd(_mm_cvtps_pd(samples), gain);
+    __m128d hi = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(samples, samples)), gain);
+    _mm_storeu_pd(out, lo);
+    _mm_storeu_pd(out + 2, hi);
+    __m128 gained = _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+    _mm_storeu_ps(win, _mm_mul_ps(gained, _mm_loadu_ps(window)));
+    sum = _mm_add_pd(sum, _mm_add_pd(_mm_mul_pd(lo, lo), _mm_mul_pd(hi, hi)));
+}
+
+// Four stereo frames, a = L0 R0 L1 R1, b = L2 R2 L3 R3
+template<class W>
+static inline void store_stereo_sse2(__m128 a, __m128 b, __m128d gain, const W* window,
+                          double* out_l, double* out_r, W* win_l, W* win_r, __m128d& sum_l, __m128d& sum_r)
+{
+    __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    store_channel_sse2(left, gain, window, out_l, win_l, sum_l);
+    store_channel_sse2(right, gain, window, out_r, win_r, sum_r);
+}
+
+static inline double hsum_sse2(__m128d v)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+// Four int16 samples sign extended to 32 bits, then to float (exact)
+static inline __m128 int16_to_float_lo_sse2(__m128i v)
+{
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+
+static inline __m128 int16_to_float_hi_sse2(__m128i v)
+{
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+}
+#endif
+
+#ifdef DSP_KERNELS_NEON
+static inline void store_channel_neon(float32x4_t samples, float64x2_t gain, const double* window, double* out, double* win, float64x2_t& sum)
+{
+    float64x2_t lo = vmulq_f64(vcvt_f64_f32(vget_low_f32(samples)), gain);
+    float64x2_t hi = vmulq_f64(vcvt_high_f64_f32(samples), gain);
+    vst1q_f64(out, lo);
+    vst1q_f64(out + 2, hi);
+    vst1q_f64(win, vmulq_f64(lo, vld1q_f64(window)));
+    vst1q_f64(win + 2, vmulq_f64(hi, vld1q_f64(window + 2)));
+    sum = vfmaq_f64(vfmaq_f64(sum, lo, lo), hi, hi);
+}
+
+static inline void store_channel_neon(float32x4_t samples, float64x2_t gain, const float* window, double* out, float* win, float64x2_t& sum)
+{
+    float64x2_t lo = vmulq_f64(vcvt_f64_f32(vget_low_f32(samples)), gain);
+    float64x2_t hi = vmulq_f64(vcvt_high_f64_f32(samples), gain);
+    vst1q_f64(out, lo);
+    vst1q_f64(out + 2, hi);
+    float32x4_t gained = vcvt_high_f32_f64(vcvt_f32_f64(lo), hi);
+    vst1q_f32(win, vmulq_f32(gained, vld1q_f32(window)));
+    sum = vfmaq_f64(vfmaq_f64(sum, lo, lo), hi, hi);
+}
+#endif
+
+template<class W>
+static void deinterleave_capture_f32(const float* in, int frames, int channels, double gain, const W* window,
+                          double* out_l, double* out_r, W* win_l, W* win_r, double sumsq[2])
+{
+    int i = 0;
+#if defined(DSP_KERNELS_SSE2)
+    if (channels <= 2)
+    {
+        __m128d vgain = _mm_set1_pd(gain);
+        __m128d sum_l = _mm_setzero_pd(), sum_r = _mm_setzero_pd();
+        if (channels == 2)
+        {
+            for (; i + 4 <= frames; i += 4)
+            {
+                store_stereo_sse2(_mm_loadu_ps(in + i*2), _mm_loadu_ps(in + i*2 + 4), vgain, window + i,
+                                  out_l + i, out_r + i, win_l + i, win_r + i, sum_l, sum_r);
+            }
+        }
+        else
+        {
+            for (; i + 4 <= frames; i += 4)
+            {
+                store_channel_sse2(_mm_loadu_ps(in + i), vgain, window + i, out_l + i, win_l + i, sum_l);
+            }
+        }
+        sumsq[0] += hsum_sse2(sum_l);
+        sumsq[1] += hsum_sse2(sum_r);
+    }
+#elif defined(DSP_KERNELS_NEON)
+    if (channels <= 2)
+    {
+        float64x2_t vgain = vdupq_n_f64(gain);
+        float64x2_t sum_l = vdupq_n_f64(0), sum_r = vdupq_n_f64(0);
+        for (; i + 4 <= frames; i += 4)
+        {
+            if (channels == 2)
+            {
+                float32x4x2_t frame = vld2q_f32(in + i*2);
+                store_channel_neon(frame.val[0], vgain, window + i, out_l + i, win_l + i, sum_l);
+                store_channel_neon(frame.val[1], vgain, window + i, out_r + i, win_r + i, sum_r);
+            }
+            else
+            {
+                store_channel_neon(vld1q_f32(in + i), vgain, window + i, out_l + i, win_l + i, sum_l);
+            }
+        }
+        sumsq[0] += vaddvq_f64(sum_l);
+        sumsq[1] += vaddvq_f64(sum_r);
+    }
+#endif
+    deinterleave_capture_scalar(in, i, frames, channels, gain, window, out_l, out_r, win_l, win_r, sumsq);
+}
+
+template<class W>
+static void deinterleave_capture_s16(const int16_t* in, int frames, int channels, double gain, const W* window,
+                          double* out_l, double* out_r, W* win_l, W* win_r, double sumsq[2])
+{
+    gain /= (double)INT16_MAX;
+    int i = 0;
+#if defined(DSP_KERNELS_SSE2)
+    if (channels <= 2)
+    {
+        __m128d vgain = _mm_set1_pd(gain);
+        __m128d sum_l = _mm_setzero_pd(), sum_r = _mm_setzero_pd();
+        if (channels == 2)
+        {
+            for (; i + 4 <= frames; i += 4)
+            {
+                __m128i v = _mm_loadu_si128((const __m128i*)(in + i*2));
+                store_stereo_sse2(int16_to_float_lo_sse2(v), int16_to_float_hi_sse2(v), vgain, window + i,
+                                  out_l + i, out_r + i, win_l + i, win_r + i, sum_l, sum_r);
+            }
+        }
+        else
+        {
+            for (; i + 4 <= frames; i += 4)
+            {
+                __m128i v = _mm_loadl_epi64((const __m128i*)(in + i));
+                store_channel_sse2(int16_to_float_lo_sse2(v), vgain, window + i, out_l + i, win_l + i, sum_l);
+            }
+        }
+        sumsq[0] += hsum_sse2(sum_l);
+        sumsq[1] += hsum_sse2(sum_r);
+    }
+#elif defined(DSP_KERNELS_NEON)
+    if (channels <= 2)
+    {
+        float64x2_t vgain = vdupq_n_f64(gain);
+        float64x2_t sum_l = vdupq_n_f64(0), sum_r = vdupq_n_f64(0);
+        for (; i + 4 <= frames; i += 4)
+        {
+            if (channels == 2)
+            {
+                int16x4x2_t frame = vld2_s16(in + i*2);
+                store_channel_neon(vcvtq_f32_s32(vmovl_s16(frame.val[0])), vgain, window + i, out_l + i, win_l + i, sum_l);
+                store_channel_neon(vcvtq_f32_s32(vmovl_s16(frame.val[1])), vgain, window + i, out_r + i, win_r + i, sum_r);
+            }
+            else
+            {
+                store_channel_neon(vcvtq_f32_s32(vmovl_s16(vld1_s16(in + i))), vgain, window + i, out_l + i, win_l + i, sum_l);
+            }
+        }
+        sumsq[0] += vaddvq_f64(sum_l);
+        sumsq[1] += vaddvq_f64(sum_r);
+    }
+#endif
+    deinterleave_capture_scalar(in, i, frames, channels, gain, window, out_l, out_r, win_l, win_r, sumsq);
+}
+
+void deinterleave_capture(const float* in, int frames, int channels, double gain, const double* window,
+                          double* out_l, double* out_r, double* win_l, double* win_r, double sumsq[2])
+{
+    deinterleave_capture_f32(in, frames, channels, gain, window, out_l, out_r, win_l, win_r, sumsq);
+}
+
+void deinterleave_capture(const int16_t* in, int frames, int channels, double gain, const double* window,
+                          double* out_l, double* out_r, double* win_l, double* win_r, double sumsq[2])
+{
+    deinterleave_capture_s16(in, frames, channels, gain, window, out_l, out_r, win_l, win_r, sumsq);
+}
+
+void deinterleave_capture(const float* in, int frames, int channels, double gain, const float* window,
+                          double* out_l, double* out_r, float* win_l, float* win_r, double sumsq[2])
+{
+    deinterleave_capture_f32(in, frames, channels, gain, window, out_l, out_r, win_l, win_r, sumsq);
+}
+
+void deinterleave_capture(const int16_t* in, int frames, int channels, double gain, const float* window,
+                          double* out_l, double* out_r, float* win_l, float* win_r, double sumsq[2])
+{
+    deinterleave_capture_s16(in, frames, channels, gain, window, out_l, out_r, win_l, win_r, sumsq);
+}
+
+template<class T>
+static inline void deinterleave_gain_scalar(const T* in, int start, int frames, int channels, double gain, double* out_l, double* out_r)
+{
+    for (int i = start; i < frames; ++i)
+    {
+        out_l[i] = in[i*channels] * gain;
+        if (channels > 1) out_r[i] = in[i*channels+1] * gain;
+    }
+}
+
+#ifdef DSP_KERNELS_SSE2
+// Four mono samples
+static inline void store_gain_sse2(__m128 samples, __m128d gain, double* out)
+{
+    _mm_storeu_pd(out, _mm_mul_pd(_mm_cvtps_pd(samples), gain));
+    _mm_storeu_pd(out + 2, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(samples, samples)), gain));
+}
+
+// Four stereo frames, a = L0 R0 L1 R1, b = L2 R2 L3 R3
+static inline void store_stereo_gain_sse2(__m128 a, __m128 b, __m128d gain, double* out_l, double* out_r)
+{
+    store_gain_sse2(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), gain, out_l);
+    store_gain_sse2(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), gain, out_r);
+}
+#endif
+
+#ifdef DSP_KERNELS_NEON
+static inline void store_gain_neon(float32x4_t samples, float64x2_t gain, double* out)
+{
+    vst1q_f64(out, vmulq_f64(vcvt_f64_f32(vget_low_f32(samples)), gain));
+    vst1q_f64(out + 2, vmulq_f64(vcvt_high_f64_f32(samples), gain));
+}
+#endif
+
+void deinterleave_gain(const float* in, int frames, int channels, double gain, double* out_l, double* out_r)
+{
+    int i = 0;
+#if defined(DSP_KERNELS_SSE2)
+    if (channels <= 2)
+    {
+        __m128d vgain = _mm_set1_pd(gain);
+        if (channels == 2)
+        {
+            for (; i + 4 <= frames; i += 4)
+            {
+                store_stereo_gain_sse2(_mm_loadu_ps(in + i*2), _mm_loadu_ps(in + i*2 + 4), vgain, out_l + i, out_r + i);
+            }
+        }
+        else
+        {
+            for (; i + 4 <= frames; i += 4) store_gain_sse2(_mm_loadu_ps(in + i), vgain, out_l + i);
+        }
+    }
+#elif defined(DSP_KERNELS_NEON)
+    if (channels <= 2)
+    {
+        float64x2_t vgain = vdupq_n_f64(gain);
+        for (; i + 4 <= frames; i += 4)
+        {
+            if (channels == 2)
+            {
+                float32x4x2_t frame = vld2q_f32(in + i*2);
+                store_gain_neon(frame.val[0], vgain, out_l + i);
+                store_gain_neon(frame.val[1], vgain, out_r + i);
+            }
+            else
+            {
+                store_gain_neon(vld1q_f32(in + i), vgain, out_l + i);
+            }
+        }
+    }
+#endif
+    deinterleave_gain_scalar(in, i, frames, channels, gain, out_l, out_r);
+}
+
+void deinterleave_gain(const int16_t* in, int frames, int channels, double gain, double* out_l, double* out_r)
+{
+    gain /= (double)INT16_MAX;
+    int i = 0;
+#if defined(DSP_KERNELS_SSE2)
+    if (channels <= 2)
+    {
+        __m128d vgain = _mm_set1_pd(gain);
+        if (channels == 2)
+        {
+            for (; i + 4 <= frames; i += 4)
+            {
+                __m128i v = _mm_loadu_si128((const __m128i*)(in + i*2));
+                store_stereo_gain_sse2(int16_to_float_lo_sse2(v), int16_to_float_hi_sse2(v), vgain, out_l + i, out_r + i);
+            }
+        }
+        else
+        {
+            for (; i + 4 <= frames; i += 4)
+            {
+                __m128i v = _mm_loadl_epi64((const __m128i*)(in + i));
+                store_gain_sse2(int16_to_float_lo_sse2(v), vgain, out_l + i);
+            }
+        }
+    }
+#elif defined(DSP_KERNELS_NEON)
+    if (channels <= 2)
+    {
+        float64x2_t vgain = vdupq_n_f64(gain);
+        for (; i + 4 <= frames; i += 4)
+        {
+            if (channels == 2)
+            {
+                int16x4x2_t frame = vld2_s16(in + i*2);
+                store_gain_neon(vcvtq_f32_s32(vmovl_s16(frame.val[0])), vgain, out_l + i);
+                store_gain_neon(vcvtq_f32_s32(vmovl_s16(frame.val[1])), vgain, out_r + i);
+            }
+            else
+            {
+                store_gain_neon(vcvtq_f32_s32(vmovl_s16(vld1_s16(in + i))), vgain, out_l + i);
+            }
+        }
+    }
+#endif
+    deinterleave_gain_scalar(in, i, frames, channels, gain, out_l, out_r);
+}
+
+double apply_window(const double* in, const double* window, double* out, int size)
+{
+    int i = 0;
+    double sumsq = 0;
+#if defined(DSP_KERNELS_SSE2)
+    __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+    for (; i + 4 <= size; i += 4)
+    {
+        __m128d a = _mm_loadu_pd(in + i);
+        __m128d b = _mm_loadu_pd(in + i + 2);
+        _mm_storeu_pd(out + i, _mm_mul_pd(a, _mm_loadu_pd(window + i)));
+        _mm_storeu_pd(out + i + 2, _mm_mul_pd(b, _mm_loadu_pd(window + i + 2)));
+        sum0 = _mm_add_pd(sum0, _mm_mul_pd(a, a));
+        sum1 = _mm_add_pd(sum1, _mm_mul_pd(b, b));
+    }
+    sumsq = hsum_sse2(_mm_add_pd(sum0, sum1));
+#elif defined(DSP_KERNELS_NEON)
+    float64x2_t sum0 = vdupq_n_f64(0), sum1 = vdupq_n_f64(0);
+    for (; i + 4 <= size; i += 4)
+    {
+        float64x2_t a = vld1q_f64(in + i);
+        float64x2_t b = vld1q_f64(in + i + 2);
+        vst1q_f64(out + i, vmulq_f64(a, vld1q_f64(window + i)));
+        vst1q_f64(out + i + 2, vmulq_f64(b, vld1q_f64(window + i + 2)));
+        sum0 = vfmaq_f64(sum0, a, a);
+        sum1 = vfmaq_f64(sum1, b, b);
+    }
+    sumsq = vaddvq_f64(vaddq_f64(sum0, sum1));
+#endif
+    for (; i < size; ++i)
+    {
+        out[i] = in[i] * window[i];
+        sumsq += in[i] * in[i];
+    }
+    return sumsq;
+}
+
+double apply_window(const double* in, const float* window, float* out, int size)
+{
+    int i = 0;
+    double sumsq = 0;
+#if defined(DSP_KERNELS_SSE2)
+    __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+    for (; i + 4 <= size; i += 4)
+    {
+        __m128d a = _mm_loadu_pd(in + i);
+        __m128d b = _mm_loadu_pd(in + i + 2);
+        __m128 samples = _mm_movelh_ps(_mm_cvtpd_ps(a), _mm_cvtpd_ps(b));
+        _mm_storeu_ps(out + i, _mm_mul_ps(samples, _mm_loadu_ps(window + i)));
+        sum0 = _mm_add_pd(sum0, _mm_mul_pd(a, a));
+        sum1 = _mm_add_pd(sum1, _mm_mul_pd(b, b));
+    }
+    sumsq = hsum_sse2(_mm_add_pd(sum0, sum1));
+#elif defined(DSP_KERNELS_NEON)
+    float64x2_t sum0 = vdupq_n_f64(0), sum1 = vdupq_n_f64(0);
+    for (; i + 4 <= size; i += 4)
+    {
+        float64x2_t a = vld1q_f64(in + i);
+        float64x2_t b = vld1q_f64(in + i + 2);
+        float32x4_t samples = vcvt_high_f32_f64(vcvt_f32_f64(a), b);
+        vst1q_f32(out + i, vmulq_f32(samples, vld1q_f32(window + i)));
+        sum0 = vfmaq_f64(sum0, a, a);
+        sum1 = vfmaq_f64(sum1, b, b);
+    }
+    sumsq = vaddvq_f64(vaddq_f64(sum0, sum1));
+#endif
+    for (; i < size; ++i)
+    {
+        out[i] = (float)in[i] * window[i];
+        sumsq += in[i] * in[i];
+    }
+    return sumsq;
+}
+
+/*
+ * log(x) = e * ln(2) + log(m), x = m * 2^e with m in [sqrt(2)/2, sqrt(2)[
+ * log(m) = 2 * atanh(t) = 2 * (t + t^3/3 + t^5/5 + t^7/7 + t^9/9), t = (m - 1) / (m + 1), |t| < 0.172
+ */
+static const double DB_LN2 = 0.69314718055994530942;
+static const double DB_PER_LN = 4.34294481903251827651; // 10 / ln(10)
+static const double DB_SQRT2 = 1.41421356237309504880;
+static const uint64_t DB_MANTISSA_MASK = 0x000FFFFFFFFFFFFFULL;
+static const uint64_t DB_ONE_BITS = 0x3FF0000000000000ULL;
+
+static inline double power_to_db_scalar(double power, double tiny, double offset, double floor_db)
+{
+    // Also replaces NaN
+    double x = power > tiny ? power : tiny;
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    double e = double(int(bits >> 52) - 1023);
+    bits = (bits & DB_MANTISSA_MASK) | DB_ONE_BITS;
+    double m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > DB_SQRT2)
+    {
+        m *= 0.5;
+        e += 1.0;
+    }
+    double t = (m - 1.0) / (m + 1.0);
+    double t2 = t * t;
+    double log_m = 2.0 * t * (1.0 + t2 * (1.0 / 3.0 + t2 * (1.0 / 5.0 + t2 * (1.0 / 7.0 + t2 * (1.0 / 9.0)))));
+    double db = (e * DB_LN2 + log_m) * DB_PER_LN + offset;
+    return db > floor_db ? db : floor_db;
+}
+
+#ifdef DSP_KERNELS_SSE2
+static inline __m128d power_to_db_sse2(__m128d power, __m128d tiny, __m128d offset, __m128d floor_db)
+{
+    // maxpd returns the second operand for NaN
+    __m128i bits = _mm_castpd_si128(_mm_max_pd(power, tiny));
+    __m128i exponent = _mm_shuffle_epi32(_mm_srli_epi64(bits, 52), _MM_SHUFFLE(3, 3, 2, 0));
+    __m128d e = _mm_sub_pd(_mm_cvtepi32_pd(exponent), _mm_set1_pd(1023.0));
+    __m128d m = _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi64x(DB_MANTISSA_MASK)),
+                                              _mm_set1_epi64x(DB_ONE_BITS)));
+    __m128d reduce = _mm_cmpgt_pd(m, _mm_set1_pd(DB_SQRT2));
+    m = _mm_sub_pd(m, _mm_and_pd(reduce, _mm_mul_pd(m, _mm_set1_pd(0.5))));
+    e = _mm_add_pd(e, _mm_and_pd(reduce, _mm_set1_pd(1.0)));
+
+    __m128d t = _mm_div_pd(_mm_sub_pd(m, _mm_set1_pd(1.0)), _mm_add_pd(m, _mm_set1_pd(1.0)));
+    __m128d t2 = _mm_mul_pd(t, t);
+    __m128d poly = _mm_add_pd(_mm_set1_pd(1.0 / 7.0), _mm_mul_pd(t2, _mm_set1_pd(1.0 / 9.0)));
+    poly = _mm_add_pd(_mm_set1_pd(1.0 / 5.0), _mm_mul_pd(t2, poly));
+    poly = _mm_add_pd(_mm_set1_pd(1.0 / 3.0), _mm_mul_pd(t2, poly));
+    poly = _mm_add_pd(_mm_set1_pd(1.0), _mm_mul_pd(t2, poly));
+    __m128d log_m = _mm_mul_pd(_mm_add_pd(t, t), poly);
+
+    __m128d db = _mm_mul_pd(_mm_add_pd(_mm_mul_pd(e, _mm_set1_pd(DB_LN2)), log_m), _mm_set1_pd(DB_PER_LN));
+    return _mm_max_pd(_mm_add_pd(db, offset), floor_db);
+}
+#endif
+
+#ifdef DSP_KERNELS_AVX2
+__attribute__((target("avx2,fma")))
+static int power_to_db_avx2(const double* power, int size, double tiny_value, double offset_value, double floor_value,
+                            double* out, double& sum)
+{
+    const __m256d tiny = _mm256_set1_pd(tiny_value);
+    const __m256d offset = _mm256_set1_pd(offset_value);
+    const __m256d floor_db = _mm256_set1_pd(floor_value);
+    const __m256i even_words = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    __m256d total = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= size; i += 4)
+    {
+        __m256i bits = _mm256_castpd_si256(_mm256_max_pd(_mm256_loadu_pd(power + i), tiny));
+        __m256i exponent = _mm256_permutevar8x32_epi32(_mm256_srli_epi64(bits, 52), even_words);
+        __m256d e = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(exponent)), _mm256_set1_pd(1023.0));
+        __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(DB_MANTISSA_MASK)),
+                                                        _mm256_set1_epi64x(DB_ONE_BITS)));
+        __m256d reduce = _mm256_cmp_pd(m, _mm256_set1_pd(DB_SQRT2), _CMP_GT_OQ);
+        m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), reduce);
+        e = _mm256_add_pd(e, _mm256_and_pd(reduce, _mm256_set1_pd(1.0)));
+
+        __m256d t = _mm256_div_pd(_mm256_sub_pd(m, _mm256_set1_pd(1.0)), _mm256_add_pd(m, _mm256_set1_pd(1.0)));
+        __m256d t2 = _mm256_mul_pd(t, t);
+        __m256d poly = _mm256_fmadd_pd(t2, _mm256_set1_pd(1.0 / 9.0), _mm256_set1_pd(1.0 / 7.0));
+        poly = _mm256_fmadd_pd(t2, poly, _mm256_set1_pd(1.0 / 5.0));
+        poly = _mm256_fmadd_pd(t2, poly, _mm256_set1_pd(1.0 / 3.0));
+        poly = _mm256_fmadd_pd(t2, poly, _mm256_set1_pd(1.0));
+        __m256d log_m = _mm256_mul_pd(_mm256_add_pd(t, t), poly);
+
+        __m256d db = _mm256_fmadd_pd(_mm256_fmadd_pd(e, _mm256_set1_pd(DB_LN2), log_m), _mm256_set1_pd(DB_PER_LN), offset);
+        db = _mm256_max_pd(db, floor_db);
+        _mm256_storeu_pd(out + i, db);
+        total = _mm256_add_pd(total, db);
+    }
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(total), _mm256_extractf128_pd(total, 1));
+    sum += _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    return i;
+}
+
+static bool cpu_has_avx2()
+{
+    static const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return has_avx2;
+}
+#endif
+
+#ifdef DSP_KERNELS_NEON
+static inline float64x2_t power_to_db_neon(float64x2_t power, float64x2_t tiny, float64x2_t offset, float64x2_t floor_db)
+{
+    // maxnm returns the number for NaN
+    uint64x2_t bits = vreinterpretq_u64_f64(vmaxnmq_f64(power, tiny));
+    int64x2_t exponent = vsubq_s64(vreinterpretq_s64_u64(vshrq_n_u64(bits, 52)), vdupq_n_s64(1023));
+    float64x2_t e = vcvtq_f64_s64(exponent);
+    float64x2_t m = vreinterpretq_f64_u64(vorrq_u64(vandq_u64(bits, vdupq_n_u64(DB_MANTISSA_MASK)), vdupq_n_u64(DB_ONE_BITS)));
+    uint64x2_t reduce = vcgtq_f64(m, vdupq_n_f64(DB_SQRT2));
+    m = vbslq_f64(reduce, vmulq_f64(m, vdupq_n_f64(0.5)), m);
+    e = vaddq_f64(e, vreinterpretq_f64_u64(vandq_u64(reduce, vreinterpretq_u64_f64(vdupq_n_f64(1.0)))));
+
+    float64x2_t t = vdivq_f64(vsubq_f64(m, vdupq_n_f64(1.0)), vaddq_f64(m, vdupq_n_f64(1.0)));
+    float64x2_t t2 = vmulq_f64(t, t);
+    float64x2_t poly = vfmaq_f64(vdupq_n_f64(1.0 / 7.0), t2, vdupq_n_f64(1.0 / 9.0));
+    poly = vfmaq_f64(vdupq_n_f64(1.0 / 5.0), t2, poly);
+    poly = vfmaq_f64(vdupq_n_f64(1.0 / 3.0), t2, poly);
+    poly = vfmaq_f64(vdupq_n_f64(1.0), t2, poly);
+    float64x2_t log_m = vmulq_f64(vaddq_f64(t, t), poly);
+
+    float64x2_t db = vfmaq_f64(offset, vfmaq_f64(log_m, e, vdupq_n_f64(DB_LN2)), vdupq_n_f64(DB_PER_LN));
+    return vmaxq_f64(db, floor_db);
+}
+#endif
+
+double power_to_db(const double* power, int size, double offset, double floor_db, double* out)
+{
+    // Smallest power reaching the floor, clamping to it also gets rid of zeros and denormals
+    const double tiny = std::max(pow(10.0, (floor_db - offset) / 10.0), DBL_MIN);
+    double sum = 0;
+    int i = 0;
+#if defined(DSP_KERNELS_AVX2)
+    if (cpu_has_avx2()) i = power_to_db_avx2(power, size, tiny, offset, floor_db, out, sum);
+#endif
+#if defined(DSP_KERNELS_SSE2)
+    {
+        const __m128d vtiny = _mm_set1_pd(tiny), voffset = _mm_set1_pd(offset), vfloor = _mm_set1_pd(floor_db);
+        __m128d total = _mm_setzero_pd();
+        for (; i + 2 <= size; i += 2)
+        {
+            __m128d db = power_to_db_sse2(_mm_loadu_pd(power + i), vtiny, voffset, vfloor);
+            _mm_storeu_pd(out + i, db);
+            total = _mm_add_pd(total, db);
+        }
+        sum += hsum_sse2(total);
+    }
+#elif defined(DSP_KERNELS_NEON)
+    {
+        const float64x2_t vtiny = vdupq_n_f64(tiny), voffset = vdupq_n_f64(offset), vfloor = vdupq_n_f64(floor_db);
+        float64x2_t total = vdupq_n_f64(0);
+        for (; i + 2 <= size; i += 2)
+        {
+            float64x2_t db = power_to_db_neon(vld1q_f64(power + i), vtiny, voffset, vfloor);
+            vst1q_f64(out + i, db);
+            total = vaddq_f64(total, db);
+        }
+        sum += vaddvq_f64(total);
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        out[i] = power_to_db_scalar(power[i], tiny, offset, floor_db);
+        sum += out[i];
+    }
+    return sum;
+}
@@ -0,0 +1,117 @@
+#define _USE_MATH_DEFINES
+#include "fir_decimator.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// Zeroth order modified Bessel function, for the Kaiser window
+static double bessel_i0(double x)
+{
+    double sum = 1, term = 1;
+    for (int k = 1; k < 50 && term > sum * 1e-17; ++k)
+    {
+        double t = x / (2. * k);
+        term *= t * t;
+        sum += term;
+    }
+    return sum;
+}
+
+void FirDecimator::init(int factor, double passband, double stopband, double attenuation_db, int channels)
+{
+    m_factor = factor;
+    m_channels = channels;
+
+    // Kaiser design formulas
+    const double transition = stopband - passband;
+    const double beta = attenuation_db > 50 ? 0.1102 * (attenuation_db - 8.7) : 0.5842 * pow(attenuation_db - 21, 0.4) + 0.07886 * (attenuation_db - 21);
+    m_length = (int)ceil((attenuation_db - 8) / (2.285 * 2. * M_PI * transition)) + 1;
+    m_length |= 1;
+
+    const double cutoff = 0.5 * (passband + stopband);
+    const int center = m_length / 2;
+    const double inv_i0_beta = 1. / bessel_i0(beta);
+    m_taps.resize(m_length);
+    double sum = 0;
+    for (int i = 0; i < m_length; ++i)
+    {
+        double x = i - center;
+        double sinc = i == center ? 2. * cutoff : sin(2. * M_PI * cutoff * x) / (M_PI * x);
+        double r = x / center;
+        double window = bessel_i0(beta * sqrt(std::max(0., 1. - r * r))) * inv_i0_beta;
+        m_taps[i] = sinc * window;
+        sum += m_taps[i];
+    }
+    // Unity DC gain
+    for (double& tap : m_taps) tap /= sum;
+
+    // Half-band zeros come out of sin() as tiny values, drop them
+    m_pair_index.clear();
+    m_pair_taps.clear();
+    m_center_tap = m_taps[center];
+    for (int k = 0; k < center; ++k)
+    {
+        if (fabs(m_taps[k]) < 1e-12 * fabs(m_center_tap)) continue;
+        m_pair_index.push_back(k);
+        m_pair_taps.push_back(m_taps[k]);
+    }
+
+    m_buffer.clear();
+    m_buffer_stride = 0;
+    reset();
+}
+
+void FirDecimator::reset()
+{
+    std::fill(m_buffer.begin(), m_buffer.end(), 0.);
+    m_phase = 0;
+}
+
+int FirDecimator::process(const double* const* in, int size, double* const* out)
+{
+    const int history = m_length - 1;
+    if (m_buffer_stride < history + size)
+    {
+        // Grow keeping each channel history
+        const int stride = history + size;
+        std::vector<double> buffer(stride * m_channels, 0.);
+        for (int c = 0; c < m_channels && m_buffer_stride; ++c)
+        {
+            memcpy(&buffer[stride * c], &m_buffer[m_buffer_stride * c], history * sizeof(double));
+        }
+        m_buffer.swap(buffer);
+        m_buffer_stride = stride;
+    }
+
+    // First block sample completing a decimation period
+    const int first = m_factor - m_phase - 1;
+    const int pairs = m_pair_index.size();
+    const int* pair_index = m_pair_index.data();
+    const double* pair_taps = m_pair_taps.data();
+    int out_count = 0;
+
+    for (int c = 0; c < m_channels; ++c)
+    {
+        double* buffer = &m_buffer[m_buffer_stride * c];
+        memcpy(buffer + history, in[c], size * sizeof(double));
+
+        out_count = 0;
+        for (int i = first; i < size; i += m_factor)
+        {
+            // Block sample i is buffer[i + history], its window is buffer[i .. i + history]
+            const double* window = buffer + i;
+            double acc = m_center_tap * window[history / 2];
+            for (int p = 0; p < pairs; ++p)
+            {
+                const int k = pair_index[p];
+                acc += pair_taps[p] * (window[k] + window[history - k]);
+            }
+            out[c][out_count++] = acc;
+        }
+
+        memmove(buffer, buffer + size, history * sizeof(double));
+    }
+
+    m_phase = (m_phase + size) % m_factor;
+    return out_count;
+}
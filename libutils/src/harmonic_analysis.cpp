@@ -0,0 +1,110 @@
+#include "harmonic_analysis.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+
+void HarmonicAnalysis::compute_thd(const double* power, int bins, double bin_hz, const PeakInterpolator& interpolator)
+{
+    // Power of each peak corrected for the scalloping loss of its fractional bin
+    double peak_power[THD_HARMONICS] = {0};
+    found_peaks = 1;
+
+    int fundamental_index = 0;
+    double max = -1;
+    for (int i = 0; i < bins; ++i)
+    {
+        if (power[i] > max)
+        {
+            max = power[i];
+            fundamental_index = i;
+        }
+    }
+
+    // The fundamental rarely falls on a bin, its fractional position places the harmonics
+    double fundamental_bin = fundamental_index;
+    harmonics_idx[0] = interpolator.locate(power, bins, fundamental_index, 0, fundamental_bin, peak_power[0]);
+    harmonics_freq[0] = fundamental_bin * bin_hz;
+
+    for (int i = 1; i < THD_HARMONICS; ++i)
+    {
+        const double expected_bin = fundamental_bin * (i+1);
+        if (lround(expected_bin) >= bins - 1) break;
+        found_peaks++;
+
+        // Harmonics drift from the ideal position with the fundamental estimate error, search around it
+        double harmonic_bin = expected_bin;
+        harmonics_idx[i] = interpolator.locate(power, bins, expected_bin, 2, harmonic_bin, peak_power[i]);
+        harmonics_freq[i] = harmonic_bin * bin_hz;
+    }
+
+    // Ratio of averaged powers, the window correction cancels out
+    double total = 0;
+    for (int i = 1; i < found_peaks; ++i)
+    {
+        total += peak_power[i] / peak_power[0];
+    }
+    thd = peak_power[0] > 0 ? sqrt(total) * 100. : 0;
+}
+
+void HarmonicAnalysis::compute_thdn(const double* power, int bins, double energy_correction, SpectrumIntegrator& spectrum)
+{
+    const double invsqrt2 = 1.0 / sqrt(2.0);
+    const double inv_bins = 1.0 / double(bins);
+
+    thdn = thdn_db = 0.;
+    thdn_audio_band = thdn_a_weighted = 0.;
+
+    // Every band power below is a query on the cumulative spectrum
+    spectrum.update(power, energy_correction);
+
+    // Start at 1, we don't want DC value
+    const double total_power = spectrum.band(1, bins);
+    fft_rms = sqrt(total_power) * invsqrt2 * inv_bins;
+
+    // Find FFT fundamental range, walk down both skirts of the peak found by compute_thd()
+    const int max_val_index = std::max(harmonics_idx[0], 1);
+    fund_idx_range_min = fund_idx_range_max = 0;
+    for (int i = max_val_index + 1; i < bins; ++i)
+    {
+        if (power[i] > power[i - 1])
+        {
+            fund_idx_range_max = i;
+            break;
+        }
+    }
+    for (int i = max_val_index - 1; i >= 0; --i)
+    {
+        if (power[i] > power[i + 1])
+        {
+            fund_idx_range_min = i;
+            break;
+        }
+    }
+
+    if (fund_idx_range_max - fund_idx_range_min <= 0)
+    {
+        fund_idx_range_max = fund_idx_range_min = 0;
+        return;
+    }
+
+    // Power of [first, last[ without the fundamental range
+    const int fund_min = fund_idx_range_min, fund_max = fund_idx_range_max;
+    auto noise_band = [&](int first, int last, bool weighted) {
+        auto band = [&](int a, int b) {return weighted ? spectrum.weighted_band(a, b) : spectrum.band(a, b);};
+        return band(first, std::min(last, fund_min)) + band(std::max(first, fund_max), last);
+    };
+
+    double noise_rms = to_rms(sqrt(noise_band(1, bins, false))) * inv_bins;
+    thdn = noise_rms / fft_rms;
+    thdn_db = linear_to_db(thdn);
+    thdn *= 100.0;
+
+    // 20Hz - 20kHz, and A-weighted noise relative to the unweighted total
+    const int audio_min = std::max(spectrum.bin(20.), 1), audio_max = spectrum.bin(20000.);
+    const double audio_power = spectrum.band(audio_min, audio_max);
+    if (audio_power > 0)
+    {
+        thdn_audio_band = sqrt(noise_band(audio_min, audio_max, false) / audio_power) * 100.0;
+        thdn_a_weighted = sqrt(noise_band(audio_min, audio_max, true) / audio_power) * 100.0;
+    }
+}
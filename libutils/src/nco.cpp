@@ -0,0 +1,130 @@
+#define _USE_MATH_DEFINES
+#include "nco.h"
+#include <cmath>
+
+// Renormalise every NCO_RENORMALIZE blocks of NCO_LANES samples, the magnitude error grows by ~1e-16 per rotation
+static const int NCO_RENORMALIZE = 256;
+
+Nco::Nco()
+{
+    reset();
+}
+
+void Nco::set_frequency(double frequency, double samplerate)
+{
+    const double step = 2. * M_PI * frequency / samplerate;
+    m_step_re = cos(step);
+    m_step_im = sin(step);
+    m_lanes_re = cos(step * NCO_LANES);
+    m_lanes_im = sin(step * NCO_LANES);
+
+    // Keep the current phase, respread the lanes with the new step
+    double re = m_re[0], im = m_im[0];
+    for (int k = 0; k < NCO_LANES; ++k)
+    {
+        m_re[k] = re;
+        m_im[k] = im;
+        double next_re = re * m_step_re - im * m_step_im;
+        im = re * m_step_im + im * m_step_re;
+        re = next_re;
+    }
+}
+
+void Nco::reset(double phase)
+{
+    double re = cos(phase), im = sin(phase);
+    for (int k = 0; k < NCO_LANES; ++k)
+    {
+        m_re[k] = re;
+        m_im[k] = im;
+        double next_re = re * m_step_re - im * m_step_im;
+        im = re * m_step_im + im * m_step_re;
+        re = next_re;
+    }
+}
+
+// Lane k takes the phase of lane k + samples, lanes past the end are rotated once more
+void Nco::advance(int samples)
+{
+    double re[NCO_LANES], im[NCO_LANES];
+    for (int k = 0; k < NCO_LANES; ++k)
+    {
+        int src = k + samples;
+        if (src < NCO_LANES)
+        {
+            re[k] = m_re[src];
+            im[k] = m_im[src];
+        }
+        else
+        {
+            src -= NCO_LANES;
+            re[k] = m_re[src] * m_lanes_re - m_im[src] * m_lanes_im;
+            im[k] = m_re[src] * m_lanes_im + m_im[src] * m_lanes_re;
+        }
+    }
+    for (int k = 0; k < NCO_LANES; ++k)
+    {
+        m_re[k] = re[k];
+        m_im[k] = im[k];
+    }
+}
+
+void Nco::renormalize()
+{
+    // First order correction of 1 / |z|, exact enough since |z| stays very close to 1
+    for (int k = 0; k < NCO_LANES; ++k)
+    {
+        double scale = 1.5 - 0.5 * (m_re[k] * m_re[k] + m_im[k] * m_im[k]);
+        m_re[k] *= scale;
+        m_im[k] *= scale;
+    }
+}
+
+void Nco::mix(const double* in, double* out_i, double* out_q, int size)
+{
+    const double lanes_re = m_lanes_re, lanes_im = m_lanes_im;
+    double re[NCO_LANES], im[NCO_LANES];
+    for (int k = 0; k < NCO_LANES; ++k)
+    {
+        re[k] = m_re[k];
+        im[k] = m_im[k];
+    }
+
+    int i = 0, blocks = 0;
+    for (; i + NCO_LANES <= size; i += NCO_LANES)
+    {
+        for (int k = 0; k < NCO_LANES; ++k)
+        {
+            out_i[i + k] = in[i + k] * re[k];
+            out_q[i + k] = in[i + k] * im[k];
+            double next_re = re[k] * lanes_re - im[k] * lanes_im;
+            im[k] = re[k] * lanes_im + im[k] * lanes_re;
+            re[k] = next_re;
+        }
+        if (++blocks == NCO_RENORMALIZE)
+        {
+            for (int k = 0; k < NCO_LANES; ++k)
+            {
+                double scale = 1.5 - 0.5 * (re[k] * re[k] + im[k] * im[k]);
+                re[k] *= scale;
+                im[k] *= scale;
+            }
+            blocks = 0;
+        }
+    }
+
+    for (int k = 0; k < NCO_LANES; ++k)
+    {
+        m_re[k] = re[k];
+        m_im[k] = im[k];
+    }
+
+    const int tail = size - i;
+    for (int k = 0; k < tail; ++k)
+    {
+        out_i[i + k] = in[i + k] * m_re[k];
+        out_q[i + k] = in[i + k] * m_im[k];
+    }
+    if (tail) advance(tail);
+    renormalize();
+}
@@ -0,0 +1,106 @@
+#define _USE_MATH_DEFINES
+#include "peak_interpolator.h"
+#include <cmath>
+#include <algorithm>
+
+// Window length used to compute its spectrum, the window shape doesn't depend on it
+static const int WINDOW_SPECTRUM_LENGTH = 512;
+
+// |W(x)|^2 of the window at x bins from its peak
+static double window_power(const double* window, int length, double x)
+{
+    double re = 0, im = 0;
+    const double step = -2. * M_PI * x / length;
+    for (int n = 0; n < length; ++n)
+    {
+        re += window[n] * cos(step * n);
+        im += window[n] * sin(step * n);
+    }
+    return re * re + im * im;
+}
+
+PeakInterpolator::PeakInterpolator()
+{
+    // Identity until init()
+    for (int j = 0; j < TABLE_SIZE; ++j)
+    {
+        m_estimate[j] = -0.5 + double(j) / (TABLE_SIZE - 1);
+        m_scalloping[j] = 1.;
+    }
+}
+
+double PeakInterpolator::gaussian_offset(double left, double center, double right)
+{
+    const double tiny = 1e-300;
+    const double a = log(std::max(left, tiny));
+    const double b = log(std::max(center, tiny));
+    const double c = log(std::max(right, tiny));
+    const double denominator = a - 2. * b + c;
+    if (denominator >= 0) return 0;
+    return std::min(std::max(0.5 * (a - c) / denominator, -0.5), 0.5);
+}
+
+void PeakInterpolator::init(double (*window_fn)(int, int))
+{
+    double window[WINDOW_SPECTRUM_LENGTH];
+    for (int n = 0; n < WINDOW_SPECTRUM_LENGTH; ++n) window[n] = window_fn(n, WINDOW_SPECTRUM_LENGTH);
+    const double peak = window_power(window, WINDOW_SPECTRUM_LENGTH, 0.);
+
+    // A tone at k + offset is seen by bin k + m through W(m - offset)
+    for (int j = 0; j < TABLE_SIZE; ++j)
+    {
+        const double offset = -0.5 + double(j) / (TABLE_SIZE - 1);
+        const double left = window_power(window, WINDOW_SPECTRUM_LENGTH, -1. - offset);
+        const double center = window_power(window, WINDOW_SPECTRUM_LENGTH, -offset);
+        const double right = window_power(window, WINDOW_SPECTRUM_LENGTH, 1. - offset);
+        m_estimate[j] = gaussian_offset(left, center, right);
+        m_scalloping[j] = center / peak;
+    }
+
+    // The table is inverted by search, it needs to be increasing
+    m_monotonic = true;
+    for (int j = 1; j < TABLE_SIZE; ++j)
+    {
+        if (m_estimate[j] <= m_estimate[j - 1]) m_monotonic = false;
+    }
+}
+
+double PeakInterpolator::true_offset(double estimate, double& scalloping) const
+{
+    if (!m_monotonic)
+    {
+        // No usable correction, keep the raw estimate
+        int j = (int)lround((estimate + 0.5) * (TABLE_SIZE - 1));
+        scalloping = m_scalloping[std::min(std::max(j, 0), TABLE_SIZE - 1)];
+        return estimate;
+    }
+
+    const double* upper = std::upper_bound(m_estimate, m_estimate + TABLE_SIZE, estimate);
+    int j = std::min(std::max(int(upper - m_estimate), 1), TABLE_SIZE - 1);
+    double t = (estimate - m_estimate[j - 1]) / (m_estimate[j] - m_estimate[j - 1]);
+    t = std::min(std::max(t, 0.), 1.);
+    scalloping = m_scalloping[j - 1] + t * (m_scalloping[j] - m_scalloping[j - 1]);
+    return -0.5 + (j - 1 + t) / (TABLE_SIZE - 1);
+}
+
+int PeakInterpolator::locate(const double* power, int size, double expected_bin, int radius, double& bin, double& peak_power) const
+{
+    const int expected = (int)lround(expected_bin);
+    const int first = std::max(expected - radius, 0);
+    const int last = std::min(expected + radius, size - 1);
+
+    int peak = std::min(std::max(expected, 0), size - 1);
+    for (int k = first; k <= last; ++k)
+    {
+        if (power[k] > power[peak]) peak = k;
+    }
+
+    bin = peak;
+    peak_power = power[peak];
+    if (peak == 0 || peak == size - 1) return peak;
+
+    double scalloping = 1.;
+    bin = peak + true_offset(gaussian_offset(power[peak - 1], power[peak], power[peak + 1]), scalloping);
+    if (scalloping > 0) peak_power = power[peak] / scalloping;
+    return peak;
+}
@@ -0,0 +1,107 @@
+#include "spectrum_averager.h"
+#include <algorithm>
+
+SpectrumAverager::~SpectrumAverager()
+{
+    destroy();
+}
+
+void SpectrumAverager::init(int size)
+{
+    destroy();
+    m_size = size;
+    m_power = new double[size];
+    m_sum = new double[size];
+    m_last = new double[size];
+    reset();
+}
+
+void SpectrumAverager::destroy()
+{
+    delete[] m_power;
+    delete[] m_sum;
+    delete[] m_last;
+    m_power = nullptr;
+    m_sum = nullptr;
+    m_last = nullptr;
+    m_size = 0;
+    m_count = 0;
+}
+
+void SpectrumAverager::reset()
+{
+    m_count = 0;
+    m_linear_complete = false;
+    if (m_size)
+    {
+        std::fill(m_power, m_power + m_size, 0.);
+        std::fill(m_sum, m_sum + m_size, 0.);
+        std::fill(m_last, m_last + m_size, 0.);
+    }
+}
+
+void SpectrumAverager::set_mode(int mode, int length)
+{
+    length = std::max(length, 1);
+    if (mode == m_mode && length == m_length) return;
+
+    m_mode = mode;
+    m_length = length;
+    reset();
+}
+
+template<class T>
+void SpectrumAverager::add(const T* spectrum)
+{
+    if (m_size == 0) return;
+
+    for (int i = 0; i < m_size; ++i)
+    {
+        m_last[i] = (double)spectrum[2*i] * spectrum[2*i] + (double)spectrum[2*i+1] * spectrum[2*i+1];
+    }
+
+    switch (m_mode)
+    {
+    case LINEAR:
+        for (int i = 0; i < m_size; ++i) m_sum[i] += m_last[i];
+        m_count++;
+        if (m_count >= m_length)
+        {
+            // Average complete, publish it and start the next one
+            const double inv_count = 1.0 / double(m_count);
+            for (int i = 0; i < m_size; ++i)
+            {
+                m_power[i] = m_sum[i] * inv_count;
+                m_sum[i] = 0;
+            }
+            m_count = 0;
+            m_linear_complete = true;
+        }
+        else if (!m_linear_complete)
+        {
+            // Nothing complete yet, show the running mean
+            const double inv_count = 1.0 / double(m_count);
+            for (int i = 0; i < m_size; ++i) m_power[i] = m_sum[i] * inv_count;
+        }
+        break;
+    case EXPONENTIAL:
+    {
+        // The first spectrum initializes the average
+        const double alpha = m_count == 0 ? 1.0 : 1.0 / double(m_length);
+        for (int i = 0; i < m_size; ++i) m_power[i] += (m_last[i] - m_power[i]) * alpha;
+        m_count = std::min(m_count + 1, m_length);
+        break;
+    }
+    case PEAK_HOLD:
+        for (int i = 0; i < m_size; ++i) m_power[i] = m_count == 0 ? m_last[i] : std::max(m_power[i], m_last[i]);
+        m_count++;
+        break;
+    default:
+        std::copy(m_last, m_last + m_size, m_power);
+        m_count = 1;
+        break;
+    }
+}
+
+template void SpectrumAverager::add<double>(const double* spectrum);
+template void SpectrumAverager::add<float>(const float* spectrum);
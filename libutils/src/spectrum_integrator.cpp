@@ -0,0 +1,95 @@
+#include "spectrum_integrator.h"
+#include <algorithm>
+#include <cmath>
+
+// IEC 61672 A-weighting power gain, 0dB at 1kHz
+static double a_weighting(double f)
+{
+    const double f2 = f * f;
+    const double c1 = 20.598997 * 20.598997, c2 = 107.65265 * 107.65265;
+    const double c3 = 737.86223 * 737.86223, c4 = 12194.217 * 12194.217;
+    const double ra = c4 * f2 * f2 / ((f2 + c1) * sqrt((f2 + c2) * (f2 + c3)) * (f2 + c4));
+    // +2.0 dB normalisation
+    const double gain = ra * 1.2589254117941673;
+    return gain * gain;
+}
+
+// Adds x to sum, the rounding error goes to error (Knuth two-sum)
+static inline void compensated_add(double& sum, double& error, double x)
+{
+    const double s = sum + x;
+    const double b = s - sum;
+    error += (sum - (s - b)) + (x - b);
+    sum = s;
+}
+
+SpectrumIntegrator::~SpectrumIntegrator()
+{
+    destroy();
+}
+
+void SpectrumIntegrator::init(int size, double bin_hz)
+{
+    destroy();
+    m_size = size;
+    m_bin_hz = bin_hz;
+    m_prefix = new double[size + 1];
+    m_prefix_error = new double[size + 1];
+    m_weighted = new double[size + 1];
+    m_weighted_error = new double[size + 1];
+    m_a_weighting = new double[size];
+    for (int i = 0; i < size; ++i) m_a_weighting[i] = a_weighting(i * bin_hz);
+    std::fill(m_prefix, m_prefix + size + 1, 0.);
+    std::fill(m_prefix_error, m_prefix_error + size + 1, 0.);
+    std::fill(m_weighted, m_weighted + size + 1, 0.);
+    std::fill(m_weighted_error, m_weighted_error + size + 1, 0.);
+}
+
+void SpectrumIntegrator::destroy()
+{
+    delete[] m_prefix;
+    delete[] m_prefix_error;
+    delete[] m_weighted;
+    delete[] m_weighted_error;
+    delete[] m_a_weighting;
+    m_prefix = m_prefix_error = m_weighted = m_weighted_error = m_a_weighting = nullptr;
+    m_size = 0;
+}
+
+void SpectrumIntegrator::update(const double* power, double scale)
+{
+    double sum = 0, error = 0, wsum = 0, werror = 0;
+    m_prefix[0] = m_prefix_error[0] = m_weighted[0] = m_weighted_error[0] = 0;
+    for (int i = 0; i < m_size; ++i)
+    {
+        const double p = power[i] * scale;
+        compensated_add(sum, error, p);
+        compensated_add(wsum, werror, p * m_a_weighting[i]);
+        m_prefix[i + 1] = sum;
+        m_prefix_error[i + 1] = error;
+        m_weighted[i + 1] = wsum;
+        m_weighted_error[i + 1] = werror;
+    }
+}
+
+double SpectrumIntegrator::band(int first, int last) const
+{
+    first = std::max(first, 0);
+    last = std::min(last, m_size);
+    if (last <= first) return 0;
+    return (m_prefix[last] - m_prefix[first]) + (m_prefix_error[last] - m_prefix_error[first]);
+}
+
+double SpectrumIntegrator::weighted_band(int first, int last) const
+{
+    first = std::max(first, 0);
+    last = std::min(last, m_size);
+    if (last <= first) return 0;
+    return (m_weighted[last] - m_weighted[first]) + (m_weighted_error[last] - m_weighted_error[first]);
+}
+
+int SpectrumIntegrator::bin(double frequency) const
+{
+    if (m_bin_hz <= 0) return 0;
+    return std::min(std::max((int)ceil(frequency / m_bin_hz), 0), m_size);
+}
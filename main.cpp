@@ -1,5 +1,6 @@
 #define _USE_MATH_DEFINES
 #include "main_widget.h"
+#include "headless_measure.h"
 #include <cstdarg>
 
 class MainWindow : public Window_SDL
@@ -57,12 +58,20 @@ void log_message(const char* format, ...)
     }
     else
     {
-        printf("%s\n", msg);
+        // Keeps stdout for the headless measurement output
+        fprintf(stderr, "%s\n", msg);
     }
 }
 
 int main(int argc, char *argv[])
 {
+    // Measurement without window nor GL context, see headless_measure.h
+    HeadlessOptions headless_options;
+    if (parse_headless_options(argc, argv, headless_options))
+    {
+        return run_headless_measurement(headless_options);
+    }
+
     App_SDL *app = App_SDL::get();
     app->set_app_name("TapeTools");
     g_main_window = new MainWindow;
@@ -1,13 +1,13 @@
 #include "main_widget.h"
 
-AudioToolWindow::AudioToolWindow(Window_SDL* win) : Widget(win, "AudioTools"), m_audiorecorder(m_audiomanager), m_audioloopback(m_audiomanager), m_signal_generator(m_audiomanager)
+AudioToolWindow::AudioToolWindow(Window_SDL* win) : Widget(win, "AudioTools"), m_audiorecorder(m_audiomanager), m_audioloopback(m_audiomanager), m_signal_generator(m_audiomanager),
+    m_analyzer(m_audiorecorder, &m_audioloopback), m_analysis_thread(m_analyzer)
 {
     set_maximized(true);
     set_movable(false);
     set_resizable(false);
     set_titlebar(false);
 
-    compute_fft_window_corrections();
     set_sound_config();
     //reset_audiomanager();
     set_theme();
@@ -17,16 +17,23 @@ AudioToolWindow::AudioToolWindow(Window_SDL* win) : Widget(win, "AudioTools"), m
     ImPlotStyle& s = ImPlot::GetStyle();
     s.LineWeight = 1.5f;
     s.PlotBorderSize = 2.f;
+
+    m_analyzer.set_wisdom_path(win->get_config_file_path(""));
+
+    update_analysis_settings();
+    m_analysis_thread.start();
 }
 
 AudioToolWindow::~AudioToolWindow()
 {
+    m_analysis_thread.stop();
+    m_analysis_thread.join();
     m_signal_generator.destroy();
 #ifdef RTL_SDR
     m_sdr_thread.stop();
     m_sdr_thread.join();
 #endif
-    destroy_capture();
+    m_analyzer.destroy_capture();
 }
 
 void AudioToolWindow::set_theme()
@@ -210,6 +217,10 @@ void AudioToolWindow::draw()
             {
                 reinit_recorder();
             }
+            if (ImGui::MenuItem("Single precision FFT", nullptr, &m_single_precision_fft))
+            {
+                reinit_recorder();
+            }
             ImGui::MenuItem("Show debug info", nullptr, &m_debug_info);
             ImGui::PopItemFlag();
 
@@ -233,16 +244,7 @@ void AudioToolWindow::draw()
             ImGui::MenuItem("Show Voltmeter", nullptr, &m_show_rms_voltage);
             if (ImGui::MenuItem("Show Wow and flutter", nullptr, &m_show_wow_flutter))
             {
-                while(App_SDL::get()->get_thread("WFtask"))
-                {
-                    App_SDL::get()->release_finished_threads();
-                }
-                // Thread is temrinated, we can do some cleanup...
-                m_longterm_audio.clear();
-                if (m_show_wow_flutter)
-                {
-                    memset((void*)m_wow_flutter_data.data(), 0, m_wow_flutter_data.size() * sizeof(typename decltype(m_wow_flutter_data)::value_type));
-                }
+                m_analyzer.reset_wow_flutter();
             }
             
             if (channelcount > 1) ImGui::MenuItem("Show L/R channel phase", nullptr, &m_compute_channel_phase);
@@ -252,16 +254,19 @@ void AudioToolWindow::draw()
         ImGui::EndMainMenuBar();
     }
 
+    // Front frame of the last fetch, the analysis thread keeps publishing meanwhile
+    const AnalysisResults& results = m_analyzer.get_results();
+
     ImGui::BeginTabBar("MaintabBar");
     
         if (ImGui::BeginTabItem("Realtime analysis"))
         {
-            draw_rt_analysis_tab();
+            draw_rt_analysis_tab(results);
             ImGui::EndTabItem();
         }
         if (ImGui::BeginTabItem("Sweep measurement"))
         {
-            draw_sweep_tab();
+            draw_sweep_tab(results);
             ImGui::EndTabItem();
         }
         
@@ -279,6 +284,8 @@ void AudioToolWindow::draw()
 
     draw_log_window();
 
+    update_analysis_settings();
+
     m_ui_time = chrono.get_elapsed_time();
 }
 
@@ -292,6 +299,7 @@ void AudioToolWindow::start_sweep_gen()
     m_sweep_target_frequency = 20;
     m_sweep_freqs.clear();
     m_sweep_values.clear();
+    m_sweep_response = SweepResponse();
     m_recorder_latency_ms = 100;
     reinit_recorder();
 
@@ -299,8 +307,30 @@ void AudioToolWindow::start_sweep_gen()
     {
         m_signal_generator_switch = true;
         reset_signal_generator();
-        m_signal_generator.set_mode(PAaudioWaveformGenerator::SINE);
-        m_signal_generator.set_pitch(m_sweep_target_frequency);
+        if (m_log_sweep)
+        {
+            // Recording starts first, the stimulus delay is found by the deconvolution
+            m_signal_generator.pause();
+            m_signal_generator.set_log_sweep(20., 20000., m_log_sweep_duration);
+            m_signal_generator.set_mode(PAaudioWaveformGenerator::LOG_SWEEP);
+            m_analyzer.start_sweep_capture(20., 20000., m_log_sweep_duration, 1.);
+            m_signal_generator.start();
+        }
+        else if (m_multitone_sweep)
+        {
+            // One period per analysis block, the whole response comes from a single block
+            m_signal_generator.pause();
+            m_signal_generator.set_multitone(m_analyzer.capture_size(), m_sweep_capture_num, 20., 20000.);
+            m_signal_generator.set_mode(PAaudioWaveformGenerator::MULTITONE);
+            m_signal_generator.start();
+            m_multitone_freqs = m_signal_generator.multitone().frequencies();
+            m_analyzer.reset_average();
+        }
+        else
+        {
+            m_signal_generator.set_mode(PAaudioWaveformGenerator::SINE);
+            m_signal_generator.set_pitch(m_sweep_target_frequency);
+        }
     }
 
     m_sweep_status = true;
@@ -312,6 +342,11 @@ void AudioToolWindow::stop_sweep_gen()
 {
     m_signal_generator_switch = false;
     m_signal_generator.pause();
+    if (m_signal_generator.mode() >= PAaudioWaveformGenerator::MULTITONE)
+    {
+        m_signal_generator.set_mode(PAaudioWaveformGenerator::SINE);
+    }
+    m_multitone_freqs.clear();
     m_sweep_status = false;
     m_sweep_started = false;
 }
@@ -330,7 +365,9 @@ void AudioToolWindow::draw_tools_windows()
                 m_wasapi_exclusive = false;
                 m_wasapi_polling = true;
                 m_use_floatingpoint = true;
-                
+
+                ScopedMutex lock(m_analyzer.compute_mutex());
+
                 // Release open streams
                 m_audioloopback.destroy();
                 m_audiorecorder.destroy();
@@ -370,6 +407,8 @@ void AudioToolWindow::draw_tools_windows()
             ImGui::SameLine();
             if (ImGui::Checkbox("use floating point", &m_use_floatingpoint))
             {
+                ScopedMutex lock(m_analyzer.compute_mutex());
+
                 // Release open streams
                 m_audioloopback.destroy();
                 m_audiorecorder.destroy();
@@ -520,9 +559,13 @@ void AudioToolWindow::get_configuration_int(std::map<std::string, int> &cnf)
 #endif
     cnf["logScaleFFT"] = m_logscale_frequency == true ? 1 : 0;
     cnf["FFTwindowType"] = m_fft_window_fn_index;
+    cnf["FFToverlap"] = m_fft_overlap_index;
+    cnf["FFTaverageMode"] = m_fft_average_mode;
+    cnf["FFTaverageCount"] = m_fft_average_count;
     cnf["showVoltmeter"] = m_show_rms_voltage == true ? 1 : 0;
     cnf["theme"] = m_uitheme;
     cnf["optimizedFFT"] = m_optimized_fft == true ? 1 : 0;
+    cnf["singlePrecisionFFT"] = m_single_precision_fft == true ? 1 : 0;
     cnf["inSampleRateIdx"] = m_in_sample_rate_idx;
     cnf["outSampleRateIdx"] = m_out_sample_rate_idx;
     cnf["use_floatingpoint"] = m_use_floatingpoint;
@@ -533,6 +576,8 @@ void AudioToolWindow::get_configuration_int(std::map<std::string, int> &cnf)
 
 void AudioToolWindow::log_message(std::string msg)
 {
+    // Also called from the analysis threads
+    ScopedMutex lock(m_log_mutex);
     m_debug_logs.push_back(msg);
     if (m_debug_logs.size() > 20)
         m_debug_logs.erase(m_debug_logs.begin());
@@ -547,10 +592,12 @@ void AudioToolWindow::draw_log_window()
         if (ImGui::Begin("Debug log", &m_show_log_window))
         {
             ImGui::BeginChild("LogRegion");
+            m_log_mutex.lock();
             for (auto &log : m_debug_logs)
             {
                 ImGui::TextUnformatted(log.c_str());
             }
+            m_log_mutex.unlock();
             if (ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
                 ImGui::SetScrollHereY(1.0f);
             ImGui::EndChild();
@@ -566,7 +613,19 @@ void AudioToolWindow::set_configuration_int(std::string s, int i)
     else if (s == "FFTwindowType")
     {
         m_fft_window_fn_index = i;
-        set_window_fn();
+        m_analyzer.set_window_fn(m_fft_window_fn_index);
+    }
+    else if (s == "FFToverlap")
+    {
+        m_fft_overlap_index = std::min(std::max(i, 0), (int)m_overlap_modes.size() - 1);
+    }
+    else if (s == "FFTaverageMode")
+    {
+        m_fft_average_mode = std::min(std::max(i, 0), (int)m_average_modes.size() - 1);
+    }
+    else if (s == "FFTaverageCount")
+    {
+        m_fft_average_count = std::min(std::max(i, 1), 256);
     }
     else if (s == "showVoltmeter")
     {
@@ -581,6 +640,10 @@ void AudioToolWindow::set_configuration_int(std::string s, int i)
     {
         m_optimized_fft = i;
     }
+    else if (s == "singlePrecisionFFT")
+    {
+        m_single_precision_fft = i;
+    }
     else if (s == "inSampleRateIdx")
     {
         m_in_sample_rate_idx = i;
@@ -627,26 +690,12 @@ void AudioToolWindow::set_configuration_float(std::string s, float f)
 
 bool AudioToolWindow::check_data_buffer()
 {
-    const int expected_buffer_size = m_capture_size * m_audiorecorder.get_channel_count();
-
-    bool data_available = false;
+    // Analysis runs in AnalysisThread, only pick up freshly published frames here
+    bool data_available = m_analyzer.fetch_new_results();
 
-    if (m_audiorecorder.get_available_samples() >= expected_buffer_size)
+    if (data_available && m_sweep_status && m_sweep_timer_chrono.get_elapsed_time() > m_measure_delay * 1000)
     {
-        data_available = compute();
-
-        if (data_available)
-        {
-            if (m_sweep_status && m_sweep_timer_chrono.get_elapsed_time() > m_measure_delay * 1000){
-                process_sweep();
-            }
-            if (m_compute_channel_phase || m_show_thd)
-                compute_thd();
-            if (m_show_thd)
-                compute_thdn();
-            if (m_compute_channel_phase)
-                compute_channels_phase();
-        }
+        process_sweep(m_analyzer.get_results());
     }
 #ifdef RTL_SDR
     data_available = m_sdr_thread.data_available();
@@ -15,19 +15,18 @@
 #include <Dsp.h>
 #include "Hack-Regular.h"
 #include "sdr_thread.h"
-
-const double WOW_FLUTTER_ANALYSIS_TIME = 5.5;
-const int    WOW_FLUTTER_DECIMATION = 20;
+#include "audio_analyzer.h"
+#include "analysis_thread.h"
 
 
 class AudioToolWindow : public Widget
 {
-    friend class WowAndFluterThread;
-
     PAaudioManager      m_audiomanager;
     PAaudioRecorder     m_audiorecorder;
     PAaudioLoopback     m_audioloopback;
     PAaudioWaveformGenerator  m_signal_generator;
+    AudioAnalyzer       m_analyzer;
+    AnalysisThread      m_analysis_thread;
 
     int  m_uitheme = 0;
     
@@ -50,37 +49,12 @@ class AudioToolWindow : public Widget
     std::string m_output_device;
     std::string m_output_loopback_device;
 
-    std::vector<double> m_sound_data1, m_sound_data2;
-    std::vector<double> m_longterm_audio;
-    std::vector<double> m_wow_flutter_data, m_wow_flutter_data_x;
-    std::vector<double> m_sound_data_x;
-    unsigned long m_wf_compute_time = 0;
-    // Wow flutter IQ data
-    std::vector<double> m_signal_i;
-    std::vector<double> m_signal_q;
-    std::vector<float> m_raw_buffer;
-    fftw_plan m_fftplanr = NULL;
-    fftw_plan m_fftplanl = NULL;
-    fftw_plan m_fftplanwow = NULL;
-    double *m_fftinl = nullptr;
-    fftw_complex *m_fftoutl = nullptr;
-    double *m_fftinr = nullptr;
-    fftw_complex *m_fftoutr = nullptr;
-    fftw_complex *m_wow_complex_out = nullptr;
-    double *m_fft_modules = nullptr;
-    double *m_fftdrawl = nullptr;
-    double *m_fftdrawr = nullptr;
-    double *m_fftfreqs = nullptr;
-    std::vector<double> m_fftwowdrawfreqs;
-    std::vector<double> m_fftdrawwow;
-    int m_capture_size = 0;
     double m_audio_gain = 1.0f;
     int m_combo_in = 0;
     int m_combo_out = 0;
     int m_combo_out_loopback = 0;
     int m_in_sample_rate_idx = 0;
     int m_out_sample_rate_idx = 0;
-    int m_wow_flutter_capture_size = 0;
     bool m_show_wf_fft_view = false;
 
     bool m_sound_setup_open = false;
@@ -92,39 +66,26 @@ class AudioToolWindow : public Widget
     float m_scopezoom = 1;;
     std::vector<std::string> m_wmodes = {"Rectangle", "Hamming", "Hann-Poisson", "Blackman", "Blackman-Harris", "Hann", "Kaiser 6"};
     std::vector<std::string> m_fftchannels = {"Left", "Right"};
-    double m_window_amplitude_correction[8] = {0.0};
-    double m_window_energy_correction[8] = {0.0};
+    std::vector<std::string> m_overlap_modes = {"None", "50%", "75%", "87.5%"};
+    std::vector<std::string> m_average_modes = {"None", "Linear", "Exponential", "Peak hold"};
 
-    double  (*m_window_fn)(int, int) = hann_fft_window;
     int     m_fft_window_fn_index = 5;
-    double  *m_current_window_cache = nullptr;
+    int     m_fft_overlap_index = 0;
+    int     m_fft_average_mode = 0;
+    int     m_fft_average_count = 8;
     bool    m_fft_channel_left = true;
     bool    m_fft_channel_right = false;
-    double  m_noise_foor = -100;
-    double  m_fft_harmonics_freq[20] = {0};
-    int     m_fft_harmonics_idx[20] = {0};
-    double  m_fft_highest_val;
-    int     m_fft_found_peaks = 0;
-    int     m_fft_fund_idx_range_min = 0;
-    int     m_fft_fund_idx_range_max = 0;
-    double  m_thd = 0;
-    double  m_thdn = 0;
-    double  m_thddb = 0;
-    double  m_fft_rms = 0;
     bool    m_show_thd = false;
 
-    double  m_left_right_db;
-    double  m_phase_diff_degrees;
-    std::vector<float> m_phase_history;
-    std::vector<float> m_lrdiff_history;
-    std::vector<float> m_phase_time;
-
-    double  m_rms_left = 0, m_rms_right = 0;
     bool    m_show_rms_voltage = false;
-    double  m_frequency_counter = 0;
 
     bool    m_sweep_started = false;
     bool    m_async_sweep = false;
+    bool    m_multitone_sweep = false;
+    std::vector<double> m_multitone_freqs;
+    bool    m_log_sweep = false;
+    float   m_log_sweep_duration = 3.f;
+    SweepResponse m_sweep_response;
     int     m_sweep_target_frequency;
     int     m_sweep_capture_num = 30;
     int     m_measure_delay = 400;
@@ -150,15 +111,16 @@ class AudioToolWindow : public Widget
     int     m_current_db_target_channel = 0;
 
     bool    m_optimized_fft = false;
+    bool    m_single_precision_fft = false;
 
     int     m_wow_test_frequency = 1;
     int     m_wow_test_frequency_custom = 3000;
-    float   m_wow_peak_detection = 0;
     int     m_wf_filter_freq_combo = 0;
-    float   m_wow_mean = 0;
 
     bool    m_trigger_on = true;
-    int     m_trigger_index = 0;
+
+    // Input recording to disk, see AudioAnalyzer::start_recording()
+    char    m_recording_path[256] = "capture.wav";
 
     bool    m_debug_info = false;
     bool    m_show_log_window = false;
@@ -168,9 +130,8 @@ class AudioToolWindow : public Widget
     bool    m_wasapi_polling = true;
 
     std::vector<std::string> m_debug_logs;
-    unsigned long m_total_compute_time=0;
+    ThreadMutex m_log_mutex;
     unsigned long m_ui_time=0;
-    ThreadMutex m_wow_data_mutex;
 #ifdef RTL_SDR
     SdrThread m_sdr_thread;
  #endif
@@ -179,9 +140,9 @@ class AudioToolWindow : public Widget
 
     void set_sound_config();
     void reset_audiomanager();
-    void detect_periods();
+    void update_analysis_settings();
 
-    void process_sweep();
+    void process_sweep(const AnalysisResults& results);
 
 public:
     AudioToolWindow(Window_SDL* win);
@@ -189,7 +150,6 @@ public:
 
     bool is_compute_on(){return m_compute_on;}
 
-    void destroy_capture();
     void init_capture();
     void reinit_recorder();
     void reset_signal_generator();
@@ -203,27 +163,20 @@ public:
     void start_sweep_gen();
     void stop_sweep_gen();
 
-    void set_window_fn(bool compute_cache = true);
-    bool compute();
-    void compute_wow_and_flutter();
-    void compute_thdn();
-    void compute_thd();
-    void compute_channels_phase();
-    void compute_fft_window_cache();
-    void compute_fft_window_corrections(int num_samples = 1000);
 
-    void draw_sweep_tab();
+    void draw_sweep_tab(const AnalysisResults& results);
     void draw_sdr();
     void draw_lcd(const float value, const ImVec2 size, const int lcd_digits_size);
-    void draw_rt_analysis_tab();
+    void draw_rt_analysis_tab(const AnalysisResults& results);
 
-    void draw_audio_time_domain_widget(int plotheight, int current_sample_rate, int channelcount);
+    void draw_audio_time_domain_widget(const AnalysisResults& results, int plotheight, int current_sample_rate, int channelcount);
     void draw_wow_flutter_widget(int channelcount, int current_samplerate, int plotheight);
-    void draw_voltmeter_widget(int channel_count);
-    void draw_audio_fft_widget(int channelcount, int current_sample_rate, int plotheight);
-    void draw_channels_phase_widget(int plotheight);
+    void draw_voltmeter_widget(const AnalysisResults& results, int channel_count);
+    void draw_audio_fft_widget(const AnalysisResults& results, int channelcount, int current_sample_rate, int plotheight);
+    void draw_channels_phase_widget(const AnalysisResults& results, int plotheight);
     void draw_tone_generator_widget();
     void draw_input_control_widget();
+    void draw_stream_stats_widget(const char* name, StreamStats& stats);
 
     void draw_tools_windows();
     void draw_log_window();
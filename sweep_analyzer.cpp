@@ -0,0 +1,199 @@
+#define _USE_MATH_DEFINES
+#include "sweep_analyzer.h"
+#include <log_sweep.h>
+#include <fftw3.h>
+#include <thread.h>
+#include <cmath>
+#include <complex>
+#include <algorithm>
+
+// Impulse response window bounds
+static const int SWEEP_MIN_WINDOW = 256;
+static const int SWEEP_MAX_WINDOW = 16384;
+// Width of the band edges tapers, in octaves
+static const double SWEEP_EDGE_OCTAVES = 1. / 6.;
+
+static int next_power_of_two(int n)
+{
+    int p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// Largest power of two window fitting in size samples
+static int window_size(double size)
+{
+    int window = SWEEP_MIN_WINDOW;
+    while (window * 2 <= std::min(size, double(SWEEP_MAX_WINDOW))) window *= 2;
+    return window;
+}
+
+// Holds the planner mutex, if any, while a plan is made or destroyed
+class PlannerLock
+{
+    ThreadMutex* m_mutex;
+public:
+    PlannerLock(ThreadMutex* mutex) : m_mutex(mutex){if (m_mutex) m_mutex->lock();}
+    ~PlannerLock(){if (m_mutex) m_mutex->unlock();}
+};
+
+// Forward real FFT of size (n / 2 + 1 complex bins) of in, zero padded to n
+static void real_fft(const double* in, int size, int n, std::vector<std::complex<double>>& out, ThreadMutex* planner_mutex)
+{
+    double* buffer = fftw_alloc_real(n);
+    fftw_complex* spectrum = fftw_alloc_complex(n / 2 + 1);
+    fftw_plan plan;
+    {
+        PlannerLock lock(planner_mutex);
+        plan = fftw_plan_dft_r2c_1d(n, buffer, spectrum, FFTW_ESTIMATE);
+    }
+    std::fill(buffer, buffer + n, 0.);
+    std::copy(in, in + std::min(size, n), buffer);
+    fftw_execute(plan);
+    out.resize(n / 2 + 1);
+    for (int i = 0; i <= n / 2; ++i) out[i] = std::complex<double>(spectrum[i][0], spectrum[i][1]);
+    {
+        PlannerLock lock(planner_mutex);
+        fftw_destroy_plan(plan);
+    }
+    fftw_free(buffer);
+    fftw_free(spectrum);
+}
+
+/*
+ * Spectrum of window samples of the impulse response starting pre samples before start,
+ * half Hann fades over the pre-roll and the last quarter of the window
+ * The pre-roll delay is removed from the phase
+ */
+static void windowed_response(const double* ir, int n, int start, int window, std::vector<std::complex<double>>& out,
+                              ThreadMutex* planner_mutex)
+{
+    const int pre = window / 8, fade_out = window / 4;
+    std::vector<double> segment(window);
+    for (int i = 0; i < window; ++i)
+    {
+        double gain = 1.;
+        if (i < pre) gain = 0.5 - 0.5 * cos(M_PI * i / pre);
+        else if (i >= window - fade_out) gain = 0.5 - 0.5 * cos(M_PI * (window - i) / fade_out);
+        segment[i] = gain * ir[((start - pre + i) % n + n) % n] / n;
+    }
+    real_fft(segment.data(), window, window, out, planner_mutex);
+    for (int i = 0; i < (int)out.size(); ++i) out[i] *= std::polar(1., 2. * M_PI * i * pre / window);
+}
+
+bool SweepAnalyzer::analyze(const double* capture, int size, double start_freq, double end_freq,
+                            double duration, int samplerate, SweepResponse& response, ThreadMutex* planner_mutex)
+{
+    response = SweepResponse();
+    std::vector<double> sweep;
+    LogSweep::render(start_freq, end_freq, duration, samplerate, sweep);
+    if (sweep.empty() || size <= 0) return false;
+
+    // Linear convolution length, no wrap of the tail onto the harmonics
+    const int n = next_power_of_two(size + (int)sweep.size());
+    std::vector<std::complex<double>> X, Y;
+    real_fft(sweep.data(), sweep.size(), n, X, planner_mutex);
+    real_fft(capture, size, n, Y, planner_mutex);
+
+    // H = Y / X in the sweep band, with raised cosine tapers at its edges
+    double max_power = 0;
+    for (const std::complex<double>& x : X) max_power = std::max(max_power, std::norm(x));
+    const double regularization = 1e-6 * max_power;
+    const double bin_hz = double(samplerate) / n;
+    const double edge = pow(2., SWEEP_EDGE_OCTAVES);
+    double* ir = fftw_alloc_real(n);
+    fftw_complex* H = fftw_alloc_complex(n / 2 + 1);
+    for (int i = 0; i <= n / 2; ++i)
+    {
+        const double f = i * bin_hz;
+        double taper = 0;
+        if (f > start_freq && f < end_freq)
+        {
+            taper = 1.;
+            if (f < start_freq * edge) taper = 0.5 - 0.5 * cos(M_PI * log(f / start_freq) / log(edge));
+            else if (f > end_freq / edge) taper = 0.5 - 0.5 * cos(M_PI * log(end_freq / f) / log(edge));
+        }
+        const std::complex<double> h = taper * Y[i] * std::conj(X[i]) / (std::norm(X[i]) + regularization);
+        H[i][0] = h.real();
+        H[i][1] = h.imag();
+    }
+    fftw_plan inverse;
+    {
+        PlannerLock lock(planner_mutex);
+        inverse = fftw_plan_dft_c2r_1d(n, H, ir, FFTW_ESTIMATE);
+    }
+    fftw_execute(inverse);
+    {
+        PlannerLock lock(planner_mutex);
+        fftw_destroy_plan(inverse);
+    }
+    fftw_free(H);
+
+    // The linear response is the highest peak, it can't be in the wrapped (negative time) part
+    int peak = 0;
+    for (int i = 0; i < n / 2; ++i)
+    {
+        if (fabs(ir[i]) > fabs(ir[peak])) peak = i;
+    }
+    if (ir[peak] == 0)
+    {
+        fftw_free(ir);
+        return false;
+    }
+    response.latency = double(peak) / samplerate;
+
+    // Harmonic k lies L * ln(k) before the linear response, the linear window can extend
+    // up to the second harmonic, the harmonic windows must fit between the two closest ones
+    const double L = LogSweep::rate(start_freq, end_freq, duration);
+    const int linear_window = window_size(L * log(2.) * samplerate);
+    const int harmonic_window = window_size(L * log(double(SWEEP_HARMONICS + 1) / SWEEP_HARMONICS) * samplerate);
+
+    std::vector<std::complex<double>> linear;
+    windowed_response(ir, n, peak, linear_window, linear, planner_mutex);
+    std::vector<std::complex<double>> spectra[SWEEP_HARMONICS];
+    for (int k = 1; k <= SWEEP_HARMONICS; ++k)
+    {
+        windowed_response(ir, n, peak - (int)lround(L * log(double(k)) * samplerate), harmonic_window, spectra[k - 1], planner_mutex);
+    }
+    fftw_free(ir);
+
+    // Bins of the sweep band
+    auto band = [&](int window, int& first, int& last) {
+        const double window_bin_hz = double(samplerate) / window;
+        first = std::max((int)ceil(start_freq / window_bin_hz), 1);
+        last = std::min((int)floor(end_freq / window_bin_hz), window / 2);
+        return window_bin_hz;
+    };
+
+    int first, last;
+    double window_bin_hz = band(linear_window, first, last);
+    for (int i = first; i <= last; ++i)
+    {
+        response.freqs.push_back(i * window_bin_hz);
+        response.magnitude_db.push_back(20. * log10(std::max(std::abs(linear[i]), 1e-10)));
+        response.phase_deg.push_back(std::arg(linear[i]) * 180. / M_PI);
+    }
+
+    // Excitation frequencies for the distortion
+    window_bin_hz = band(harmonic_window, first, last);
+    for (int i = first; i <= last; ++i)
+    {
+        const double fundamental = std::abs(spectra[0][i]);
+        response.harmonic_freqs.push_back(i * window_bin_hz);
+
+        double distortion = 0;
+        for (int k = 2; k <= SWEEP_HARMONICS; ++k)
+        {
+            double level = NAN;
+            if (k * i <= last && fundamental > 0)
+            {
+                const double ratio = std::abs(spectra[k - 1][k * i]) / fundamental;
+                distortion += ratio * ratio;
+                level = 20. * log10(std::max(ratio, 1e-10));
+            }
+            response.harmonics_db[k - 2].push_back(level);
+        }
+        response.thd_percent.push_back(sqrt(distortion) * 100.);
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+class ThreadMutex;
+
+const int SWEEP_HARMONICS = 5;
+
+/*
+ * Frequency response of a log sweep capture, one point per FFT bin between
+ * the sweep start and end frequencies
+ * The harmonic impulse responses are closer to each other than the linear one is to the
+ * first of them, they get a shorter window and their own, coarser, frequency axis.
+ * Harmonic levels are relative to the fundamental, for an excitation at harmonic_freqs[i],
+ * NaN where the harmonic is above the sweep end frequency
+ */
+struct SweepResponse
+{
+    std::vector<double> freqs;
+    std::vector<double> magnitude_db;
+    std::vector<double> phase_deg;
+
+    std::vector<double> harmonic_freqs;
+    std::vector<double> thd_percent;
+    std::vector<double> harmonics_db[SWEEP_HARMONICS - 1];
+    // Delay of the linear impulse response from the start of the capture
+    double  latency = 0;
+};
+
+/*
+ * Offline exponential sweep deconvolution
+ * The capture is divided by the stimulus spectrum (regularized outside the sweep band)
+ * which gives the linear impulse response followed, at negative times, by one impulse
+ * response per harmonic order. Each one is windowed and transformed separately.
+ */
+class SweepAnalyzer
+{
+public:
+    /*
+     * capture must start when the stimulus starts and be long enough to hold its tail
+     * The FFTW plans are made with planner_mutex held, when given
+     * Returns false if no impulse response is found
+     */
+    static bool analyze(const double* capture, int size, double start_freq, double end_freq,
+                        double duration, int samplerate, SweepResponse& response, ThreadMutex* planner_mutex = nullptr);
+};
@@ -0,0 +1,145 @@
+#define _USE_MATH_DEFINES
+#include "wow_flutter_stream.h"
+#include <utils.h>
+#include <cmath>
+#include <algorithm>
+
+// IQ low-pass cutoff, the decimation stages keep [0, WF_IQ_PASSBAND] free of aliases
+static const double WF_IQ_PASSBAND = 700.;
+// The mixer image (twice the 1kHz lowest reference minus the band-pass) must not reach the output
+static const double WF_IQ_STOPBAND = 1700.;
+static const double WF_STOPBAND_DB = 80.;
+
+void WowFlutterStream::init(int samplerate, int decimation, int history_size)
+{
+    m_samplerate = samplerate;
+    m_decimation = decimation;
+
+    // Factors of two first as half-band stages, the remaining factor last
+    std::vector<int> factors;
+    int remaining = decimation;
+    while (remaining % 2 == 0 && remaining > 2)
+    {
+        factors.push_back(2);
+        remaining /= 2;
+    }
+    if (remaining > 1) factors.push_back(remaining);
+
+    // Each stage only has to stop what would alias into the final band,
+    // [output Nyquist, output rate - passband] of the last stage is left to the IQ low-pass
+    // unless the output rate is high enough to let the mixer image through
+    const double output_nyquist = 0.5 * samplerate / decimation;
+    double rate = samplerate;
+    m_decimators.resize(factors.size());
+    for (size_t i = 0; i < factors.size(); ++i)
+    {
+        const double out_rate = rate / factors[i];
+        const bool last = i + 1 == factors.size();
+        const double stopband = last ? std::min(out_rate - WF_IQ_PASSBAND, WF_IQ_STOPBAND) : out_rate - output_nyquist;
+        const double passband = factors[i] == 2 && !last ? rate / 2. - stopband : WF_IQ_PASSBAND;
+        m_decimators[i].init(factors[i], passband / rate, stopband / rate, WF_STOPBAND_DB, 2);
+        rate = out_rate;
+    }
+    m_deviation.assign(history_size, 0.);
+    m_history_i.assign(history_size, 0.);
+    m_history_q.assign(history_size, 0.);
+    // Force the filters setup on the next configure()
+    m_reference_frequency = 0;
+    reset();
+}
+
+void WowFlutterStream::configure(int reference_frequency, int filter_freq)
+{
+    if (reference_frequency == m_reference_frequency && filter_freq == m_filter_freq) return;
+
+    m_reference_frequency = reference_frequency;
+    m_filter_freq = filter_freq;
+    m_nco.set_frequency(m_reference_frequency, m_samplerate);
+
+    m_prefilter.setup(4, m_samplerate, m_reference_frequency, 500, 0.2);
+    m_iq_lowpass_filter.setup(4, m_samplerate / m_decimation, WF_IQ_PASSBAND, 0.1);
+    if (m_filter_freq > 0) m_wf_lowpass_filter.setup(4, m_samplerate / m_decimation, m_filter_freq, 0.1);
+
+    // The history holds the previous carrier, start over
+    reset();
+}
+
+void WowFlutterStream::reset()
+{
+    m_prefilter.reset();
+    m_iq_lowpass_filter.reset();
+    m_wf_lowpass_filter.reset();
+    m_nco.reset();
+    for (FirDecimator& decimator : m_decimators) decimator.reset();
+    m_last_i = m_last_q = 0;
+    m_write_pos = 0;
+    m_filled = 0;
+    std::fill(m_deviation.begin(), m_deviation.end(), 0.);
+    std::fill(m_history_i.begin(), m_history_i.end(), 0.);
+    std::fill(m_history_q.begin(), m_history_q.end(), 0.);
+}
+
+void WowFlutterStream::process(const double* audio, int size)
+{
+    if (m_deviation.empty() || m_reference_frequency <= 0 || size <= 0) return;
+
+    if ((int)m_block.size() < size)
+    {
+        m_block.resize(size);
+        m_block_i.resize(size);
+        m_block_q.resize(size);
+    }
+
+    // Pre-filter audio data with a bandfilter to isolate the carrier frequency as much as possible
+    std::copy(audio, audio + size, m_block.begin());
+    double* prefilter_chans[1] = {m_block.data()};
+    m_prefilter.process(size, prefilter_chans);
+
+    // Transform real signal to IQ data
+    m_nco.mix(m_block.data(), m_block_i.data(), m_block_q.data(), size);
+
+    // Decimate, then low pass filter IQ signal to suppress fundamental at the output rate
+    double* iq_chans[2] = {m_block_i.data(), m_block_q.data()};
+    int decimated = size;
+    for (FirDecimator& decimator : m_decimators) decimated = decimator.process(iq_chans, decimated, iq_chans);
+    if (decimated == 0) return;
+    m_iq_lowpass_filter.process(decimated, iq_chans);
+
+    // Phase difference between two consecutive decimated samples gives the frequency drift
+    const double phase_to_hz = m_samplerate / (m_decimation * M_PI * 2.);
+    const int history_size = m_deviation.size();
+    for (int i = 0; i < decimated; ++i)
+    {
+        const double prev_i = i > 0 ? m_block_i[i-1] : m_last_i;
+        const double prev_q = i > 0 ? m_block_q[i-1] : m_last_q;
+        double phase0 = complex_argument(prev_q, prev_i);
+        double phase1 = complex_argument(m_block_q[i], m_block_i[i]);
+        double deviation = wrap_phase(phase0 - phase1) * phase_to_hz;
+
+        if (m_filter_freq > 0)
+        {
+            double* wf_chans[1] = {&deviation};
+            m_wf_lowpass_filter.process(1, wf_chans);
+        }
+
+        m_deviation[m_write_pos] = deviation;
+        m_history_i[m_write_pos] = m_block_i[i];
+        m_history_q[m_write_pos] = m_block_q[i];
+        if (++m_write_pos == history_size) m_write_pos = 0;
+        if (m_filled < history_size) m_filled++;
+    }
+    m_last_i = m_block_i[decimated-1];
+    m_last_q = m_block_q[decimated-1];
+}
+
+void WowFlutterStream::get_history(double* deviation, double* signal_i, double* signal_q) const
+{
+    // m_write_pos is the oldest sample once the history is full, zeros before that
+    const int tail = m_deviation.size() - m_write_pos;
+    std::copy(m_deviation.begin() + m_write_pos, m_deviation.end(), deviation);
+    std::copy(m_deviation.begin(), m_deviation.begin() + m_write_pos, deviation + tail);
+    std::copy(m_history_i.begin() + m_write_pos, m_history_i.end(), signal_i);
+    std::copy(m_history_i.begin(), m_history_i.begin() + m_write_pos, signal_i + tail);
+    std::copy(m_history_q.begin() + m_write_pos, m_history_q.end(), signal_q);
+    std::copy(m_history_q.begin(), m_history_q.begin() + m_write_pos, signal_q + tail);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <Dsp.h>
+#include <nco.h>
+#include <fir_decimator.h>
+
+/*
+ * Streaming wow & flutter demodulator
+ * Audio is pushed block by block as it is captured, every sample goes once through the
+ * carrier band-pass and the IQ mixer, then a chain of decimating FIR stages brings the IQ
+ * down to the output rate where the IQ low-pass runs. All filters keep their state between blocks.
+ * The phase difference of consecutive decimated IQ samples gives the carrier frequency deviation,
+ * it is kept with the decimated I/Q in a circular history covering the analysis time
+ */
+class WowFlutterStream
+{
+    int     m_samplerate = 0;
+    int     m_decimation = 1;
+    int     m_reference_frequency = 0;
+    int     m_filter_freq = 0;
+
+    Dsp::SimpleFilter <Dsp::ChebyshevI::BandPass <4>, 1> m_prefilter;
+    Dsp::SimpleFilter <Dsp::ChebyshevI::LowPass <4>, 2> m_iq_lowpass_filter;
+    Dsp::SimpleFilter <Dsp::ChebyshevI::LowPass <4>, 1> m_wf_lowpass_filter;
+
+    // Mixer and decimation chain state, half-band stages first
+    Nco     m_nco;
+    std::vector<FirDecimator> m_decimators;
+    double  m_last_i = 0, m_last_q = 0;
+
+    // One block of filtered audio and IQ, grown on demand, decimated in place
+    std::vector<double> m_block, m_block_i, m_block_q;
+
+    // Circular decimated history
+    std::vector<double> m_deviation, m_history_i, m_history_q;
+    int     m_write_pos = 0;
+    int     m_filled = 0;
+
+public:
+    WowFlutterStream(){}
+
+    void init(int samplerate, int decimation, int history_size);
+    // Restarts the analysis if the reference or the output low-pass changes
+    void configure(int reference_frequency, int filter_freq);
+    void reset();
+
+    void process(const double* audio, int size);
+
+    // True until the history has been filled once
+    bool buffering() const {return m_filled < (int)m_deviation.size();}
+    int  history_size() const {return m_deviation.size();}
+
+    // Copy the history, oldest first, deviation in Hz and decimated I/Q
+    void get_history(double* deviation, double* signal_i, double* signal_q) const;
+};